@@ -0,0 +1,42 @@
+/**
+ * Measures how evaluateBatch() scales over a million distinct seeded expressions, one in a
+ * hundred of which ends in a division by zero, from one thread to one per core.
+ */
+#include "bench.h"
+
+#include <thread>
+
+int main() {
+    constexpr size_t count = 1000000;
+
+    // No term is zero and none is multiplied, so only the appended / 0 can fail, where && or ||
+    // does not skip it.
+    mt19937 random(benchSeed);
+    const char* ops[] = {"+", "-", "/", "%", "<", "==", "&&", "||"};
+    vector<string> texts;
+    texts.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        string text = to_string(i);
+        for (size_t term = 0, terms = 4 + random() % 8; term < terms; ++term)
+            text += string(" ") + ops[random() % 8] + " (" + to_string(1 + random() % 999) + " + " + to_string(random() % 50) + ")";
+        if (i % 100 == 0) text += " / 0";
+        texts.push_back(move(text));
+    }
+    vector<string_view> expressions(texts.begin(), texts.end());
+
+    MathLogicEvaluator evaluator;
+    unsigned cores = max(1u, thread::hardware_concurrency());
+    vector<unsigned> threadCounts;
+    for (unsigned threads = 1; threads < cores; threads *= 2) threadCounts.push_back(threads);
+    threadCounts.push_back(cores);
+
+    printf("%zu expressions, %u cores\n", count, cores);
+    printf("%-8s %10s %9s %11s\n", "threads", "Mexpr/s", "speedup", "efficiency");
+    double oneThread = 0;
+    for (unsigned threads : threadCounts) {
+        double time = nanosecondsPerItem(count, [&] { keep(evaluator.evaluateBatch(expressions, threads).values[count / 2]); });
+        if (threads == 1) oneThread = time;
+        printf("%-8u %10.2f %8.2fx %10.0f%%\n", threads, millionsPerSecond(time), oneThread / time, 100.0 * oneThread / time / threads);
+    }
+    return 0;
+}
@@ -0,0 +1,54 @@
+/**
+ * Shared helpers for the benchmarks in bench/. Each benchmark is a standalone program that
+ * includes main.cpp, builds its inputs from a fixed seed, and prints one line per measurement.
+ */
+#ifndef MATHLOGIC_BENCH_H
+#define MATHLOGIC_BENCH_H
+
+#define MATHLOGIC_NO_MAIN
+#include "../main.cpp"
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+
+/**
+ * Seed of every generated input, so that each run measures the same work.
+ */
+constexpr uint32_t benchSeed = 42;
+
+/**
+ * Results are stored here so that the compiler cannot drop the work that computed them.
+ */
+inline volatile int64_t benchSink;
+
+template <typename Value>
+inline void keep(const Value& value) {
+    benchSink = static_cast<int64_t>(value);
+}
+
+/**
+ * Runs body, which processes items items, once to warm up and then five times, and returns
+ * the fastest time per item in nanoseconds.
+ */
+template <typename Body>
+double nanosecondsPerItem(uint64_t items, Body body) {
+    body();
+    double best = numeric_limits<double>::infinity();
+    for (int round = 0; round < 5; ++round) {
+        auto start = chrono::steady_clock::now();
+        body();
+        chrono::duration<double, nano> elapsed = chrono::steady_clock::now() - start;
+        best = min(best, elapsed.count() / static_cast<double>(items));
+    }
+    return best;
+}
+
+/**
+ * Millions of items per second for a time per item in nanoseconds.
+ */
+inline double millionsPerSecond(double nanoseconds) {
+    return 1e3 / nanoseconds;
+}
+
+#endif
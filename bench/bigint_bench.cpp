@@ -0,0 +1,75 @@
+/**
+ * Measures BigInt programs: run() on values that stay inline against the same program in
+ * int64_t, products of operands from 1024 to 65536 bits, around and far beyond the Karatsuba
+ * threshold, and powers of a 61-bit base.
+ */
+#include "bench.h"
+
+/**
+ * A seeded value of about bits bits: a random 61-bit odd number raised to bits / 61.
+ */
+static BigInt randomValue(const MathLogicEvaluator& evaluator, mt19937_64& random, size_t bits) {
+    BigInt base = static_cast<int64_t>((random() >> 3) | 1);
+    BigInt exponent = static_cast<int64_t>(bits / 61);
+    BigInt slots[] = {base, exponent};
+    return evaluator.compile<BigInt>("x ^ y", {"x", "y"}).run(slots);
+}
+
+int main() {
+    MathLogicEvaluator evaluator;
+    mt19937_64 random(benchSeed);
+
+    // Inline values: every intermediate fits in 64 bits, so BigInt stays on machine arithmetic.
+    const vector<string> small = {"x * y + z", "(x + y) * (z - 3) % 1000", "x ^ 3 - y * z", "x > y && y * z < 5000 || z == 7"};
+    const vector<string> layout = {"x", "y", "z"};
+    constexpr uint64_t runs = 1000000;
+    constexpr size_t rows = 1024;
+    uniform_int_distribution<int64_t> values(1, 1000);
+    vector<int64_t> wideSlots(rows * 3);
+    for (int64_t& slot : wideSlots) slot = values(random);
+    vector<BigInt> bigSlots(wideSlots.begin(), wideSlots.end());
+
+    printf("%-34s %10s %10s  (Mevals/s)\n", "inline values", "int64_t", "BigInt");
+    for (const string& expression : small) {
+        CompiledExpression64 wide = evaluator.compile<int64_t>(expression, layout);
+        CompiledExpressionBig big = evaluator.compile<BigInt>(expression, layout);
+        double wideTime = nanosecondsPerItem(runs, [&] {
+            for (uint64_t i = 0; i < runs; ++i) keep(wide.run(span<const int64_t>(wideSlots).subspan(i % rows * 3, 3)));
+        });
+        double bigTime = nanosecondsPerItem(runs, [&] {
+            for (uint64_t i = 0; i < runs; ++i) keep(big.run(span<const BigInt>(bigSlots).subspan(i % rows * 3, 3)).isInline());
+        });
+        printf("%-34s %10.1f %10.1f\n", expression.c_str(), millionsPerSecond(wideTime), millionsPerSecond(bigTime));
+    }
+
+    // Doubling the operands costs about 4x with schoolbook products and 3x with Karatsuba.
+    printf("\n%-34s %12s %10s\n", "x * y", "us/product", "vs half");
+    CompiledExpressionBig product = evaluator.compile<BigInt>("x * y", {"x", "y"});
+    double previous = 0;
+    for (size_t bits = 1024; bits <= 65536; bits *= 2) {
+        BigInt slots[] = {randomValue(evaluator, random, bits), randomValue(evaluator, random, bits)};
+        uint64_t products = max<uint64_t>(20, (uint64_t(1) << 26) / (bits * bits / 1024));
+        double time = nanosecondsPerItem(products, [&] {
+            for (uint64_t i = 0; i < products; ++i) keep(product.run(slots).isInline());
+        });
+        char name[32];
+        snprintf(name, sizeof(name), "%zu-bit operands", bits);
+        if (previous) printf("%-34s %12.2f %9.2fx\n", name, time / 1e3, time / previous);
+        else printf("%-34s %12.2f %10s\n", name, time / 1e3, "");
+        previous = time;
+    }
+
+    printf("\n%-34s %12s\n", "x ^ y, 61-bit x", "us/power");
+    CompiledExpressionBig power = evaluator.compile<BigInt>("x ^ y", {"x", "y"});
+    for (int64_t exponent : {100, 1000, 10000}) {
+        BigInt slots[] = {static_cast<int64_t>((random() >> 3) | 1), exponent};
+        uint64_t powers = max<uint64_t>(10, 20000000 / (exponent * exponent / 10 + 1));
+        double time = nanosecondsPerItem(powers, [&] {
+            for (uint64_t i = 0; i < powers; ++i) keep(power.run(slots).isInline());
+        });
+        char name[32];
+        snprintf(name, sizeof(name), "y = %lld", static_cast<long long>(exponent));
+        printf("%-34s %12.2f\n", name, time / 1e3);
+    }
+    return 0;
+}
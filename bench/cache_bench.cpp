@@ -0,0 +1,58 @@
+/**
+ * Measures evaluate() on requests drawn from 4000 distinct rule strings with a Zipfian
+ * distribution, as the cache grows from disabled to holding every string: the hit rate, and
+ * throughput on one thread and on one thread per core sharing the evaluator.
+ */
+#include "bench.h"
+
+#include <thread>
+
+int main() {
+    constexpr size_t distinct = 4000, requests = 1 << 20;
+    constexpr double exponent = 1.0;
+
+    // Rules of six to ten terms. No term is zero and none is multiplied by another, so no rule
+    // divides by zero or overflows.
+    mt19937 random(benchSeed);
+    const char* ops[] = {"+", "-", "%", "==", "<", "&&", "||", "/"};
+    vector<string> rules;
+    for (size_t i = 0; i < distinct; ++i) {
+        string rule = to_string(i + 1);
+        for (size_t term = 0, terms = 5 + random() % 5; term < terms; ++term)
+            rule += string(" ") + ops[random() % 8] + " (" + to_string(1 + random() % 99) + " * " + to_string(1 + random() % 9) + ")";
+        rules.push_back(move(rule));
+    }
+
+    // Rank r is requested with probability proportional to 1 / r^exponent.
+    vector<double> weights(distinct);
+    for (size_t rank = 0; rank < distinct; ++rank) weights[rank] = 1.0 / pow(static_cast<double>(rank + 1), exponent);
+    discrete_distribution<size_t> ranks(weights.begin(), weights.end());
+    vector<const string*> sequence(requests);
+    for (const string*& request : sequence) request = &rules[ranks(random)];
+
+    auto evaluateRange = [&](const MathLogicEvaluator& evaluator, size_t begin, size_t end) {
+        int64_t sum = 0;
+        for (size_t i = begin; i < end; ++i) sum += evaluator.evaluate(*sequence[i]);
+        keep(sum);
+    };
+
+    unsigned cores = max(1u, thread::hardware_concurrency());
+    printf("Zipf exponent %.1f over %zu rules, %u cores\n", exponent, distinct, cores);
+    printf("%-10s %10s %14s %14s  (Mevals/s)\n", "capacity", "hit rate", "1 thread", "all cores");
+    for (size_t capacity : {size_t(0), size_t(16), size_t(64), size_t(256), size_t(1024), distinct}) {
+        MathLogicEvaluator evaluator;
+        evaluator.setCacheCapacity(capacity);
+        evaluateRange(evaluator, 0, requests);
+        double hitRate = capacity ? 100.0 * evaluator.cacheHits() / requests : 0.0;
+
+        double single = nanosecondsPerItem(requests, [&] { evaluateRange(evaluator, 0, requests); });
+        double shared = nanosecondsPerItem(requests, [&] {
+            vector<thread> workers;
+            for (unsigned worker = 0; worker < cores; ++worker)
+                workers.emplace_back(evaluateRange, cref(evaluator), requests * worker / cores, requests * (worker + 1) / cores);
+            for (thread& worker : workers) worker.join();
+        });
+        printf("%-10zu %9.1f%% %14.1f %14.1f\n", capacity, hitRate, millionsPerSecond(single), millionsPerSecond(shared));
+    }
+    return 0;
+}
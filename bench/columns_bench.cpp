@@ -0,0 +1,44 @@
+/**
+ * Measures rows per second for one predicate over a million rows of int64_t columns: run() on
+ * one row at a time against runColumns(), which executes each instruction across a block of
+ * rows, and filter(), which returns the selected rows.
+ */
+#include "bench.h"
+
+int main() {
+    const vector<string> corpus = {
+        "temp > 30 && load < 5",
+        "(temp - 32) * 5 / 9 > load * 4",
+        "temp * temp + load * load - 2 * temp * load < 400",
+        "(temp % 7 == 3 || load % 5 == 1) && temp + load != 50",
+        "!(temp < 10) && (load ^ 2 + temp) % 11 > 4"};
+    const vector<string> layout = {"temp", "load"};
+    constexpr size_t rows = 1 << 20;
+
+    mt19937 random(benchSeed);
+    uniform_int_distribution<int64_t> temps(-20, 60), loads(0, 10);
+    vector<int64_t> temp(rows), load(rows), slots(2 * rows), results(rows);
+    for (size_t row = 0; row < rows; ++row) {
+        slots[2 * row] = temp[row] = temps(random);
+        slots[2 * row + 1] = load[row] = loads(random);
+    }
+    span<const int64_t> columns[] = {temp, load};
+
+    MathLogicEvaluator evaluator;
+    printf("%-54s %9s %9s %9s  (Mrows/s)\n", "", "run", "columns", "filter");
+    for (const string& expression : corpus) {
+        CompiledExpression64 program = evaluator.compile<int64_t>(expression, layout);
+        double run = nanosecondsPerItem(rows, [&] {
+            for (size_t row = 0; row < rows; ++row) results[row] = program.run(span<const int64_t>(slots).subspan(2 * row, 2));
+            keep(results[rows / 2]);
+        });
+        double block = nanosecondsPerItem(rows, [&] {
+            program.runColumns(columns, results);
+            keep(results[rows / 2]);
+        });
+        double filter = nanosecondsPerItem(rows, [&] { keep(program.filter(columns, rows).size()); });
+        printf("%-54s %9.1f %9.1f %9.1f\n", expression.c_str(), millionsPerSecond(run), millionsPerSecond(block),
+               millionsPerSecond(filter));
+    }
+    return 0;
+}
@@ -0,0 +1,58 @@
+/**
+ * Measures what compiling once saves on rules over three variables. Without compile(), a caller
+ * writes each row's values into the text and evaluate() tokenizes, parses and compiles it on
+ * every call; compile() + run() still compiles every call, while a CompiledExpression only runs
+ * its program. The operands are variables, so constant folding cannot reduce the programs.
+ */
+#include "bench.h"
+
+int main() {
+    const vector<string> corpus = {
+        "(a + b) * 2 - c / 5",
+        "!(a > b) && (c <= 4 || a == b)",
+        "((c % 4) ^ 2 + a) * -b >= -100",
+        "a + b * c - a / 2 + (b - c) * 7 % 3",
+        "(((a - c) * (b + 1)) / 6 != 9) || b ^ 3 == c"};
+    const vector<string> layout = {"a", "b", "c"};
+    constexpr uint64_t calls = 200000;
+    constexpr size_t rows = 1024;
+
+    mt19937 random(benchSeed);
+    uniform_int_distribution<int> values(1, 1000);
+    vector<int> slots(rows * layout.size());
+    for (int& slot : slots) slot = values(random);
+
+    // Every expression with each row's values written in place of a, b and c.
+    vector<string> texts;
+    for (size_t row = 0; row < rows; ++row) {
+        for (const string& expression : corpus) {
+            string text;
+            for (char c : expression) {
+                if (c >= 'a' && c <= 'c') text += to_string(slots[row * layout.size() + (c - 'a')]);
+                else text += c;
+            }
+            texts.push_back(move(text));
+        }
+    }
+
+    MathLogicEvaluator evaluator;
+    evaluator.setCacheCapacity(0);
+    vector<CompiledExpression> programs;
+    for (const string& expression : corpus) programs.push_back(evaluator.compile(expression, layout));
+    auto row = [&](uint64_t i) { return span<const int>(slots).subspan(i / corpus.size() % rows * layout.size(), layout.size()); };
+
+    double evaluate = nanosecondsPerItem(calls, [&] {
+        for (uint64_t i = 0; i < calls; ++i) keep(evaluator.evaluate(texts[i % texts.size()]));
+    });
+    double compileAndRun = nanosecondsPerItem(calls, [&] {
+        for (uint64_t i = 0; i < calls; ++i) keep(evaluator.compile(corpus[i % corpus.size()], layout).run(row(i)));
+    });
+    double run = nanosecondsPerItem(calls, [&] {
+        for (uint64_t i = 0; i < calls; ++i) keep(programs[i % programs.size()].run(row(i)));
+    });
+
+    printf("%-36s %8.1f ns/call\n", "evaluate() on text with the values", evaluate);
+    printf("%-36s %8.1f ns/call\n", "compile() + run()", compileAndRun);
+    printf("%-36s %8.1f ns/call\n", "CompiledExpression::run()", run);
+    return 0;
+}
@@ -0,0 +1,47 @@
+/**
+ * Measures run() latency on expressions that repeat a subexpression two or three times, against
+ * twins that write each repeat over other variables bound to the same values, so that nothing
+ * in them is shared and every repeat is computed.
+ */
+#include "bench.h"
+
+int main() {
+    // Each expression over a, b and c, then its twin, which reads d, e, f and g, h, i instead.
+    const vector<pair<string, string>> corpus = {
+        {"(a * b + c) > 10 && (a * b + c) < 20", "(a * b + c) > 10 && (d * e + f) < 20"},
+        {"(a * b + c) * (a * b + c) - (a * b + c) % 7", "(a * b + c) * (d * e + f) - (g * h + i) % 7"},
+        {"((a + b) * (a - c) + (a + b) * (a - c) / 3) * ((a + b) * (a - c) - 1)",
+         "((a + b) * (a - c) + (d + e) * (d - f) / 3) * ((g + h) * (g - i) - 1)"},
+        {"(a * a + b * b + c * c) > 50 && (a * a + b * b + c * c) < 2000 && (a * a + b * b + c * c) % 3 == 0",
+         "(a * a + b * b + c * c) > 50 && (d * d + e * e + f * f) < 2000 && (g * g + h * h + i * i) % 3 == 0"},
+        {"(a - b) * (a - b) + (b - c) * (b - c) + (c - a) * (c - a) > (a - b) * (b - c) * (c - a)",
+         "(a - b) * (d - e) + (b - c) * (e - f) + (c - a) * (f - d) > (g - h) * (h - i) * (i - g)"}};
+    const vector<string> layout = {"a", "b", "c", "d", "e", "f", "g", "h", "i"};
+    constexpr uint64_t runs = 1000000;
+    constexpr size_t rows = 1024;
+
+    // Small enough that no product overflows int.
+    mt19937 random(benchSeed);
+    uniform_int_distribution<int> values(1, 30);
+    vector<int> slots(rows * layout.size());
+    for (size_t row = 0; row < rows; ++row) {
+        int* slot = &slots[row * layout.size()];
+        for (int variable = 0; variable < 3; ++variable) slot[variable] = slot[variable + 3] = slot[variable + 6] = values(random);
+    }
+
+    MathLogicEvaluator evaluator;
+    auto measure = [&](const string& expression) {
+        CompiledExpression program = evaluator.compile(expression, layout);
+        return nanosecondsPerItem(runs, [&] {
+            for (uint64_t i = 0; i < runs; ++i)
+                keep(program.run(span<const int>(slots).subspan(i % rows * layout.size(), layout.size())));
+        });
+    };
+
+    printf("%-52s %10s %10s\n", "", "separate", "shared");
+    for (const auto& [shared, separate] : corpus) {
+        double separateTime = measure(separate), sharedTime = measure(shared);
+        printf("%-52.52s %7.1f ns %7.1f ns  %.2fx\n", shared.c_str(), separateTime, sharedTime, separateTime / sharedTime);
+    }
+    return 0;
+}
@@ -0,0 +1,40 @@
+/**
+ * Measures run() on flat and nested expressions with the same operators: x + y - x + y ...
+ * keeps two values on the stack, while x + (y - (x + (y ...))) needs one per operand. Programs
+ * up to 64 values deep run on a stack buffer, deeper ones on the per-thread arena.
+ */
+#include "bench.h"
+
+int main() {
+    const vector<string> layout = {"x", "y"};
+    constexpr uint64_t operations = 1 << 24;
+    constexpr size_t rows = 1024;
+
+    mt19937 random(benchSeed);
+    uniform_int_distribution<int> values(-1000, 1000);
+    vector<int> slots(rows * 2);
+    for (int& slot : slots) slot = values(random);
+
+    MathLogicEvaluator evaluator;
+    printf("%-10s %12s %12s  (ns/run)\n", "operands", "flat", "nested");
+    for (int operands : {8, 32, 64, 65, 256, 1024}) {
+        string flat = "x", nested = "x";
+        for (int i = 1; i < operands; ++i) {
+            const char* op = i % 2 ? " + " : " - ";
+            flat += op + string(i % 2 ? "y" : "x");
+            nested = string(i % 2 ? "y" : "x") + op + "(" + nested + ")";
+        }
+
+        uint64_t runs = operations / operands;
+        printf("%-10d", operands);
+        for (const string* expression : {&flat, &nested}) {
+            CompiledExpression program = evaluator.compile(*expression, layout);
+            double time = nanosecondsPerItem(runs, [&] {
+                for (uint64_t i = 0; i < runs; ++i) keep(program.run(span<const int>(slots).subspan(i % rows * 2, 2)));
+            });
+            printf(" %12.1f", time);
+        }
+        printf("\n");
+    }
+    return 0;
+}
@@ -0,0 +1,132 @@
+/**
+ * Measures what constant folding removes from 2000 seeded rules written the way generated rules
+ * are, with unit constants such as (3600 * 24) * a, x + 0, 1 && b and !!b: the operations
+ * eliminated, and run() throughput against twins of the rules whose literals are variables
+ * bound to the same values, so nothing in them can be folded.
+ */
+#include "bench.h"
+
+/**
+ * BasicCompiledExpression lets ProgramTest read its bytecode; here it counts instructions.
+ */
+struct ProgramTest {
+    /**
+     * The instructions of a program, and how many of them compute rather than push a value.
+     */
+    static pair<size_t, size_t> count(const CompiledExpression& program) {
+        size_t instructions = 0, operations = 0;
+        const uint8_t* end = program.code.data() + program.code.size();
+        for (const uint8_t* pc = program.code.data(); pc != end; pc += 1 + CompiledExpression::immediateSize(static_cast<OpCode>(*pc))) {
+            OpCode op = static_cast<OpCode>(*pc);
+            ++instructions;
+            operations += op != OpCode::PUSH && op != OpCode::LOAD;
+        }
+        return {instructions, operations};
+    }
+};
+
+/**
+ * Writes a rule twice: with literals, and with each literal replaced by a new variable k0, k1, ...
+ * whose name is appended to layout and its value to constants.
+ */
+struct RuleWriter {
+    mt19937& random;
+    string folded, twin;
+    vector<string> layout = {"a", "b", "c", "d"};
+    vector<int> constants;
+
+    explicit RuleWriter(mt19937& random) : random(random) {}
+
+    void text(const string& part) {
+        folded += part;
+        twin += part;
+    }
+
+    void literal(int value) {
+        folded += to_string(value);
+        layout.push_back("k" + to_string(constants.size()));
+        twin += layout.back();
+        constants.push_back(value);
+    }
+
+    void variable() { text(string(1, "abcd"[random() % 4])); }
+
+    void term(int depth) {
+        switch (random() % (depth ? 6 : 4)) {
+        case 0: variable(); break;
+        case 1: text("("), literal(3600), text(" * "), literal(24), text(") * "), variable(); break;
+        case 2: variable(), text(random() % 2 ? " + " : " - "), literal(0); break;
+        case 3: literal(1), text(" * "), variable(); break;
+        case 4: text("("), term(depth - 1), text(" + "), term(depth - 1), text(")"); break;
+        default: text("("), term(depth - 1), text(" % ("), literal(60), text(" * "), literal(60), text("))"); break;
+        }
+    }
+
+    void condition() {
+        switch (random() % 4) {
+        case 0: literal(1), text(" && "); break;
+        case 1: text("!!"); break;
+        case 2: literal(0), text(" || "); break;
+        default: break;
+        }
+        text("("), term(2), text(random() % 2 ? " > " : " <= "), term(2), text(")");
+    }
+};
+
+int main() {
+    constexpr size_t rules = 2000, rows = 1024;
+    constexpr uint64_t runs = 1000000;
+
+    mt19937 random(benchSeed);
+    uniform_int_distribution<int> values(1, 100);
+    MathLogicEvaluator evaluator;
+    vector<CompiledExpression> folded, twins;
+    vector<vector<int>> slots;
+    size_t sourceBytes = 0, twinInstructions = 0, twinOperations = 0, foldedInstructions = 0, foldedOperations = 0;
+    for (size_t rule = 0; rule < rules; ++rule) {
+        RuleWriter writer(random);
+        writer.condition();
+        writer.text(" && ");
+        writer.condition();
+
+        folded.push_back(evaluator.compile(writer.folded, {"a", "b", "c", "d"}));
+        twins.push_back(evaluator.compile(writer.twin, writer.layout));
+        sourceBytes += writer.folded.size();
+
+        auto [instructions, operations] = ProgramTest::count(folded.back());
+        foldedInstructions += instructions;
+        foldedOperations += operations;
+        tie(instructions, operations) = ProgramTest::count(twins.back());
+        twinInstructions += instructions;
+        twinOperations += operations;
+
+        // Rows of a, b, c and d, each followed by the constants.
+        vector<int> ruleSlots;
+        for (size_t row = 0; row < rows; ++row) {
+            for (int variable = 0; variable < 4; ++variable) ruleSlots.push_back(values(random));
+            ruleSlots.insert(ruleSlots.end(), writer.constants.begin(), writer.constants.end());
+        }
+        slots.push_back(move(ruleSlots));
+    }
+
+    auto measure = [&](const vector<CompiledExpression>& programs, bool withConstants) {
+        return nanosecondsPerItem(runs, [&] {
+            for (uint64_t i = 0; i < runs; ++i) {
+                const CompiledExpression& program = programs[i % rules];
+                const vector<int>& ruleSlots = slots[i % rules];
+                size_t width = ruleSlots.size() / rows, row = i / rules % rows;
+                keep(program.run(span<const int>(ruleSlots).subspan(row * width, withConstants ? width : 4)));
+            }
+        });
+    };
+    double twinTime = measure(twins, true), foldedTime = measure(folded, false);
+
+    printf("%zu rules, %.1f bytes on average\n", rules, static_cast<double>(sourceBytes) / rules);
+    printf("%-12s %14s %14s %10s\n", "", "instructions", "operations", "Mevals/s");
+    printf("%-12s %14zu %14zu %10.1f\n", "unfolded", twinInstructions, twinOperations, millionsPerSecond(twinTime));
+    printf("%-12s %14zu %14zu %10.1f\n", "folded", foldedInstructions, foldedOperations, millionsPerSecond(foldedTime));
+    printf("eliminated %zu instructions (%.0f%%) and %zu operations (%.0f%%), %.2fx faster\n",
+           twinInstructions - foldedInstructions, 100.0 * (twinInstructions - foldedInstructions) / twinInstructions,
+           twinOperations - foldedOperations, 100.0 * (twinOperations - foldedOperations) / twinOperations, twinTime / foldedTime);
+    return 0;
+}
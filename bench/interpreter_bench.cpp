@@ -0,0 +1,44 @@
+/**
+ * Measures the latency of running bytecode in the interpreter, one row per run() call. The
+ * operands are variables, so constant folding cannot reduce the programs to one literal.
+ */
+#include "bench.h"
+
+int main() {
+    const vector<string> corpus = {
+        "(a + b) * 2 - c / 5",
+        "!(a > b) && (c <= 4 || a == b)",
+        "((c % 4) ^ 2 + a) * -b >= -100",
+        "a + b * c - a / 2 + (b - c) * 7 % 3",
+        "(((a - c) * (b + 1)) / 6 != 9) || b ^ 3 == c"};
+    const vector<string> layout = {"a", "b", "c"};
+    constexpr uint64_t runs = 1000000;
+    constexpr size_t rows = 1024;
+
+    mt19937 random(benchSeed);
+    uniform_int_distribution<int> values(1, 1000);
+    vector<int> slots(rows * layout.size());
+    for (int& slot : slots) slot = values(random);
+
+    // Deeper than the 64-entry inline stack, so the value stack comes from the per-thread arena.
+    string deep = "a";
+    for (int i = 0; i < 100; ++i) deep = "(b - " + deep + ")";
+
+    MathLogicEvaluator evaluator;
+    for (const string& expression : corpus) {
+        CompiledExpression program = evaluator.compile(expression, layout);
+        double time = nanosecondsPerItem(runs, [&] {
+            for (uint64_t i = 0; i < runs; ++i)
+                keep(program.run(span<const int>(slots).subspan(i % rows * layout.size(), layout.size())));
+        });
+        printf("%-46s %6.1f ns/run\n", expression.c_str(), time);
+    }
+
+    CompiledExpression program = evaluator.compile(deep, layout);
+    double time = nanosecondsPerItem(runs, [&] {
+        for (uint64_t i = 0; i < runs; ++i)
+            keep(program.run(span<const int>(slots).subspan(i % rows * layout.size(), layout.size())));
+    });
+    printf("%-46s %6.1f ns/run\n", "100 nested subtractions", time);
+    return 0;
+}
@@ -0,0 +1,38 @@
+/**
+ * Measures front-end throughput on literal-heavy input: compiling sums of 500 seeded literals
+ * of a fixed number of digits, in tokens and bytes of source per second.
+ */
+#include "bench.h"
+
+int main() {
+    constexpr int terms = 500;
+    constexpr uint64_t expressionsPerRound = 64;
+    constexpr uint64_t compiles = 2000;
+
+    mt19937_64 random(benchSeed);
+    MathLogicEvaluator evaluator;
+    for (int digits : {4, 8, 12, 16, 18}) {
+        // Each sum starts with a variable, so (x + a) + b ... cannot be folded.
+        uniform_int_distribution<int64_t> literals(1, static_cast<int64_t>(pow(10.0, digits)) - 1);
+        vector<string> sums;
+        size_t bytes = 0;
+        while (sums.size() < expressionsPerRound) {
+            string sum(1, 'x');
+            for (int term = 0; term < terms; ++term) {
+                string literal = to_string(literals(random));
+                sum.append(" + ").append(digits - literal.size(), '0').append(literal);
+            }
+            bytes += sum.size();
+            sums.push_back(move(sum));
+        }
+
+        double time = nanosecondsPerItem(compiles, [&] {
+            for (uint64_t i = 0; i < compiles; ++i)
+                keep(evaluator.compile<int64_t>(sums[i % sums.size()], {"x"}).variables().size());
+        });
+        double tokens = 2.0 * terms + 1, averageBytes = static_cast<double>(bytes) / sums.size();
+        printf("%2d-digit literals  %6.1f Mtok/s  %6.1f MB/s\n", digits, tokens * millionsPerSecond(time),
+               averageBytes * millionsPerSecond(time));
+    }
+    return 0;
+}
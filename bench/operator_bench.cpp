@@ -0,0 +1,45 @@
+/**
+ * Measures tokenizeExpression() on operator-dense input, where most characters are operators:
+ * two-character operators with and without spaces, runs of unary operators, and single-character
+ * ones, in tokens and bytes of source per second.
+ */
+#include "bench.h"
+
+/**
+ * MathLogicEvaluator lets ParserTest call its front ends, as in tests/parser_test.cpp.
+ */
+struct ParserTest {
+    static size_t tokenize(string_view expression, VariableLayout& variables, vector<Token>& tokens) {
+        variables.clear();
+        MathLogicEvaluator::tokenizeExpression(expression, variables, false, tokens);
+        return tokens.size();
+    }
+};
+
+int main() {
+    // Each pattern is repeated to about 4 KB; patterns end so that repeats join into one expression.
+    const vector<pair<string, string>> patterns = {
+        {"two-character, packed", "1==2!=3>=4<=5&&6||7<=8>=9!=0=="},
+        {"two-character, spaced", "1 == 2 != 3 >= 4 <= 5 && 6 || 7 <= 8 >= 9 != 0 == "},
+        {"unary runs", "!-!-!x++--+--!!-y*"},
+        {"one-character", "1+2-3*4/5%6^7<8>9+(1-2)*"},
+        {"comparisons of names", "temp>=limit&&load<=cap||rate!=base&&"}};
+    constexpr size_t patternBytes = 4096, expressions = 64;
+
+    VariableLayout variables;
+    vector<Token> tokens;
+    printf("%-24s %10s %10s\n", "", "Mtok/s", "MB/s");
+    for (const auto& [name, pattern] : patterns) {
+        string expression;
+        while (expression.size() < patternBytes) expression += pattern;
+        expression += "1";
+
+        size_t count = ParserTest::tokenize(expression, variables, tokens);
+        double time = nanosecondsPerItem(expressions * expression.size(), [&] {
+            for (size_t i = 0; i < expressions; ++i) keep(ParserTest::tokenize(expression, variables, tokens));
+        });
+        double bytesPerToken = static_cast<double>(expression.size()) / count;
+        printf("%-24s %10.1f %10.1f\n", name.c_str(), millionsPerSecond(time * bytesPerToken), millionsPerSecond(time));
+    }
+    return 0;
+}
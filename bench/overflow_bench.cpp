@@ -0,0 +1,61 @@
+/**
+ * Measures what each overflow policy costs for int programs: run() in the interpreter and in
+ * native code, and runColumns(), on seeded rows where nothing overflows.
+ */
+#include "bench.h"
+
+int main() {
+    const vector<string> corpus = {"a * b + c - 7", "(a + b) * (c - 3) > 100 && a != b", "-a * b + a * a - (b + 2) * 17 <= 1000",
+                                   "a / b + a % b * c"};
+    const vector<string> layout = {"a", "b", "c"};
+    constexpr uint64_t runs = 1000000;
+    constexpr size_t rows = 1 << 16;
+
+    mt19937 random(benchSeed);
+    uniform_int_distribution<int> values(1, 1000);
+    vector<int> slots(3 * rows), columns[3];
+    for (int& slot : slots) slot = values(random);
+    for (size_t column = 0; column < 3; ++column) {
+        columns[column].resize(rows);
+        for (size_t row = 0; row < rows; ++row) columns[column][row] = slots[3 * row + column];
+    }
+    span<const int> inputs[] = {columns[0], columns[1], columns[2]};
+    vector<int> results(rows);
+
+    printf("%-40s %-12s %8s %8s %8s\n", "", "", "run", "native", "block");
+    for (const string& expression : corpus) {
+        for (auto [policy, name] : {pair{OverflowPolicy::Wrapping, "wrapping"}, pair{OverflowPolicy::Checked, "checked"},
+                                    pair{OverflowPolicy::Saturating, "saturating"}}) {
+            MathLogicEvaluator interpreted, native;
+            interpreted.setOverflowPolicy(policy);
+            native.setOverflowPolicy(policy);
+            native.setJitThreshold(1);
+            printf("%-40s %-12s", policy == OverflowPolicy::Wrapping ? expression.c_str() : "", name);
+
+            CompiledExpression program = interpreted.compile(expression, layout);
+            double run = nanosecondsPerItem(runs, [&] {
+                for (uint64_t i = 0; i < runs; ++i) keep(program.run(span<const int>(slots).subspan(i % rows * 3, 3)));
+            });
+            printf(" %8.1f", millionsPerSecond(run));
+
+            CompiledExpression compiled = native.compile(expression, layout);
+            keep(compiled.run(span<const int>(slots).first(3)));
+            if (compiled.isNative()) {
+                double time = nanosecondsPerItem(runs, [&] {
+                    for (uint64_t i = 0; i < runs; ++i) keep(compiled.run(span<const int>(slots).subspan(i % rows * 3, 3)));
+                });
+                printf(" %8.1f", millionsPerSecond(time));
+            } else {
+                printf(" %8s", "-");
+            }
+
+            double block = nanosecondsPerItem(rows, [&] {
+                program.runColumns(inputs, results);
+                keep(results[rows / 2]);
+            });
+            printf(" %8.1f\n", millionsPerSecond(block));
+        }
+    }
+    printf("run() and native in Mevals/s, runColumns() in Mrows/s\n");
+    return 0;
+}
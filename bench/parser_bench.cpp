@@ -0,0 +1,82 @@
+/**
+ * Measures front-end throughput in MB/s of expression text: the Pratt parser against the
+ * tokenize, validate and shunting-yard passes it replaced, both producing the postfix program,
+ * on seeded expressions of three sizes over five variables.
+ */
+#include "bench.h"
+
+/**
+ * MathLogicEvaluator lets ParserTest call its front ends, as in tests/parser_test.cpp.
+ */
+struct ParserTest {
+    static size_t pratt(string_view expression, VariableLayout& variables, vector<Token>& postfix) {
+        variables.clear();
+        MathLogicEvaluator::parseToPostfix(expression, variables, false, postfix);
+        return postfix.size();
+    }
+
+    static size_t threePasses(string_view expression, VariableLayout& variables, vector<Token>& tokens,
+                              vector<Token>& postfix, vector<Token>& operators) {
+        variables.clear();
+        MathLogicEvaluator::tokenizeExpression(expression, variables, false, tokens);
+        MathLogicEvaluator::validateTokenSequence(tokens);
+        MathLogicEvaluator::convertToPostfix(tokens, postfix, operators);
+        return postfix.size();
+    }
+};
+
+/**
+ * A seeded expression of about terms operands: numbers and variables joined by binary
+ * operators, some negated or negated logically, some groups in parentheses.
+ */
+static string randomExpression(mt19937& random, int terms) {
+    static const char* const operators[] = {" + ", " - ", " * ", " / ", " % ", " ^ ", " == ", " != ", " < ",
+                                            " >= ", " && ", " || ", "+", "*", ">", "<="};
+    static const char* const variables[] = {"temp", "load_5", "x", "count", "rate"};
+    string text;
+    int open = 0;
+    for (int term = 0; term < terms; ++term) {
+        if (term) text += operators[random() % size(operators)];
+        if (random() % 5 == 0) {
+            text += '(';
+            ++open;
+        }
+        if (random() % 8 == 0) text += random() % 2 ? "-" : "!";
+        if (random() % 2) text += variables[random() % size(variables)];
+        else text += to_string(random() % 100000);
+        if (open && random() % 4 == 0) {
+            text += ')';
+            --open;
+        }
+    }
+    text.append(open, ')');
+    return text;
+}
+
+int main() {
+    constexpr size_t corpusBytes = 1 << 20;
+
+    mt19937 random(benchSeed);
+    VariableLayout variables;
+    vector<Token> tokens, postfix, operators;
+    printf("%-22s %10s %10s  (MB/s)\n", "", "Pratt", "3 passes");
+    for (int terms : {4, 32, 256}) {
+        vector<string> corpus;
+        size_t bytes = 0;
+        while (bytes < corpusBytes) {
+            corpus.push_back(randomExpression(random, terms));
+            bytes += corpus.back().size();
+        }
+
+        double pratt = nanosecondsPerItem(bytes, [&] {
+            for (const string& expression : corpus) keep(ParserTest::pratt(expression, variables, postfix));
+        });
+        double passes = nanosecondsPerItem(bytes, [&] {
+            for (const string& expression : corpus) keep(ParserTest::threePasses(expression, variables, tokens, postfix, operators));
+        });
+        char name[32];
+        snprintf(name, sizeof(name), "%d terms, %zu bytes", terms, bytes / corpus.size());
+        printf("%-22s %10.1f %10.1f\n", name, millionsPerSecond(pratt), millionsPerSecond(passes));
+    }
+    return 0;
+}
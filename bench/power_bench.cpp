@@ -0,0 +1,42 @@
+/**
+ * Measures run() throughput of expressions using ^ over two variables, in the interpreter and,
+ * where it is available, in native code.
+ */
+#include "bench.h"
+
+int main() {
+    const vector<string> corpus = {"x ^ 2 + y ^ 2", "x ^ 3 - y", "(x + y) ^ 5 % 1000", "x ^ y", "2 ^ (y % 8) + x ^ 2"};
+    const vector<string> layout = {"x", "y"};
+    constexpr uint64_t runs = 1000000;
+    constexpr size_t rows = 1024;
+
+    // Small enough that no result overflows int.
+    mt19937 random(benchSeed);
+    uniform_int_distribution<int> bases(1, 20), exponents(0, 6);
+    vector<int> slots(rows * 2);
+    for (size_t row = 0; row < rows; ++row) {
+        slots[2 * row] = bases(random);
+        slots[2 * row + 1] = exponents(random);
+    }
+
+    MathLogicEvaluator interpreted, native;
+    native.setJitThreshold(1);
+    printf("%-24s %12s %12s  (Mevals/s)\n", "", "interpreter", "native");
+    for (const string& expression : corpus) {
+        printf("%-24s", expression.c_str());
+        for (MathLogicEvaluator* evaluator : {&interpreted, &native}) {
+            CompiledExpression program = evaluator->compile(expression, layout);
+            keep(program.run(span<const int>(slots).first(2)));
+            if (evaluator == &native && !program.isNative()) {
+                printf(" %12s", "-");
+                continue;
+            }
+            double time = nanosecondsPerItem(runs, [&] {
+                for (uint64_t i = 0; i < runs; ++i) keep(program.run(span<const int>(slots).subspan(i % rows * 2, 2)));
+            });
+            printf(" %12.1f", millionsPerSecond(time));
+        }
+        printf("\n");
+    }
+    return 0;
+}
@@ -0,0 +1,50 @@
+/**
+ * Measures run() on predicates with a cheap left side and an expensive right side, as the share
+ * of rows on which the left side decides the result goes from none to all. Each is compared with
+ * an eager twin that combines the two sides arithmetically, so the right side always runs.
+ */
+#include "bench.h"
+
+int main() {
+    // About 25 operations over y, between 1 and 20 so that no power overflows int.
+    const string expensive = "((y ^ 5 + y * y * 3) % 97 + (y * 7 + 1) % 13 * (y ^ 3 % 11) - (y ^ 4 / (y + 2)) % 29 > 50)";
+    const vector<string> layout = {"x", "y"};
+    constexpr uint64_t runs = 1000000;
+    constexpr size_t rows = 1000;
+
+    // x is a permutation of 0 to 99 repeated, so x < k holds on exactly k% of the rows.
+    mt19937 random(benchSeed);
+    uniform_int_distribution<int> values(1, 20);
+    vector<int> slots(rows * 2);
+    vector<int> percentiles(100);
+    iota(percentiles.begin(), percentiles.end(), 0);
+    for (size_t row = 0; row < rows; ++row) {
+        if (row % 100 == 0) shuffle(percentiles.begin(), percentiles.end(), random);
+        slots[2 * row] = percentiles[row % 100];
+        slots[2 * row + 1] = values(random);
+    }
+
+    MathLogicEvaluator evaluator;
+    auto measure = [&](const string& expression) {
+        CompiledExpression program = evaluator.compile(expression, layout);
+        return nanosecondsPerItem(runs, [&] {
+            for (uint64_t i = 0; i < runs; ++i) keep(program.run(span<const int>(slots).subspan(i % rows * 2, 2)));
+        });
+    };
+
+    printf("%-28s %10s %10s\n", "", "eager", "short");
+    for (int percent : {0, 10, 50, 90, 100}) {
+        string limit = to_string(percent);
+        // Both run their right side where x < k, on percent% of the rows.
+        string cheapAnd = "x < " + limit, cheapOr = "x >= " + limit;
+        for (auto [label, shortCircuit, eager] :
+             {tuple{"&&", cheapAnd + " && " + expensive, "(" + cheapAnd + ") * " + expensive},
+              tuple{"||", cheapOr + " || " + expensive, "(" + cheapOr + ") + " + expensive + " > 0"}}) {
+            double eagerTime = measure(eager), shortTime = measure(shortCircuit);
+            char name[32];
+            snprintf(name, sizeof(name), "%s, right side on %d%%", label, percent);
+            printf("%-28s %7.1f ns %7.1f ns  %.2fx\n", name, eagerTime, shortTime, eagerTime / shortTime);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,57 @@
+/**
+ * Measures how the value type changes throughput: run() one row at a time and runColumns()
+ * a block at a time, for 32-, 64- and 128-bit programs in the interpreter.
+ */
+#include "bench.h"
+
+static const vector<string> layout = {"a", "b", "c"};
+
+/**
+ * Prints run() in Mevals/s and runColumns() in Mrows/s for one program of type Value, over
+ * rows of seeded values between 1 and 1000.
+ */
+template <typename Value>
+static void measure(const MathLogicEvaluator& evaluator, const string& expression) {
+    constexpr uint64_t runs = 1000000;
+    constexpr size_t rows = 1 << 16;
+
+    mt19937 random(benchSeed);
+    uniform_int_distribution<int> values(1, 1000);
+    vector<Value> slots(3 * rows), columns[3];
+    for (Value& slot : slots) slot = values(random);
+    for (size_t column = 0; column < 3; ++column) {
+        columns[column].resize(rows);
+        for (size_t row = 0; row < rows; ++row) columns[column][row] = slots[3 * row + column];
+    }
+
+    BasicCompiledExpression<Value> program = evaluator.compile<Value>(expression, layout);
+    double run = nanosecondsPerItem(runs, [&] {
+        for (uint64_t i = 0; i < runs; ++i) keep(program.run(span<const Value>(slots).subspan(i % rows * 3, 3)));
+    });
+
+    span<const Value> inputs[] = {columns[0], columns[1], columns[2]};
+    vector<Value> results(rows);
+    double block = nanosecondsPerItem(rows, [&] {
+        program.runColumns(inputs, results);
+        keep(results[rows / 2]);
+    });
+    printf(" %6.1f %6.1f", millionsPerSecond(run), millionsPerSecond(block));
+}
+
+int main() {
+    MathLogicEvaluator evaluator;
+    printf("%-36s %13s %13s %13s\n", "", "int", "int64_t", "__int128");
+    printf("%-36s", "");
+    for (int type = 0; type < 3; ++type) printf(" %6s %6s", "run", "block");
+    printf("\n");
+    for (const string expression : {"a * b + c - 7", "(a + b) * (c - 3) > 100 && a != b", "a / b + a % b * c", "a ^ 2 + b ^ 3"}) {
+        printf("%-36s", expression.c_str());
+        measure<int>(evaluator, expression);
+        measure<int64_t>(evaluator, expression);
+#if MATHLOGIC_INT128
+        measure<__int128>(evaluator, expression);
+#endif
+        printf("\n");
+    }
+    return 0;
+}
@@ -1,254 +1,3680 @@
 #include <iostream>
-#include <stack>
 #include <vector>
 #include <string>
 #include <unordered_map>
+#include <list>
+#include <deque>
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <exception>
+#include <string_view>
 #include <stdexcept>
-#include <cctype>
 #include <cmath>
+#include <charconv>
+#include <cstdint>
+#include <climits>
+#include <cstring>
+#include <algorithm>
+#include <memory>
+#include <span>
+#include <limits>
+#include <type_traits>
+#include <compare>
+#include <bit>
+
+// The native code tier needs the System V x86-64 calling convention and mmap().
+#if defined(__x86_64__) && (defined(__linux__) || defined(__APPLE__))
+#define MATHLOGIC_JIT 1
+#include <sys/mman.h>
+#else
+#define MATHLOGIC_JIT 0
+#endif
+
+// 128-bit values are a GCC and Clang extension.
+#if defined(__SIZEOF_INT128__)
+#define MATHLOGIC_INT128 1
+#else
+#define MATHLOGIC_INT128 0
+#endif
 
 using namespace std;
 
+/**
+ * Categories of expression errors, reported per item by MathLogicEvaluator::evaluateBatch().
+ */
+enum class ErrorCode : uint8_t {
+    None,             // evaluated successfully
+    Syntax,           // malformed expression
+    UnknownVariable,  // name not in the fixed variable layout
+    Range,            // literal does not fit the value type
+    MissingValue,     // no value or column supplied for a variable
+    DivisionByZero,
+    Overflow          // result does not fit the value type
+};
+
 /**
  * Custom exception type for signaling parsing or evaluation errors in expressions.
  */
 class ExpressionError : public runtime_error {
 public:
-    ExpressionError(const string& msg) : runtime_error(msg) {}
+    ExpressionError(const string& msg, ErrorCode code = ErrorCode::Syntax) : runtime_error(msg), errorCode(code) {}
+
+    ErrorCode code() const { return errorCode; }
+
+private:
+    ErrorCode errorCode;
 };
 
 /**
- * MathLogicEvaluator: A class for parsing and evaluating complex infix expressions
- * with both arithmetic and logical operators, including error checking.
+ * Throws the error for an operator that failed at run time, pointing at the operator's position.
  */
-class MathLogicEvaluator {
-private:
+[[noreturn]] inline void throwEvaluationError(ErrorCode code, uint32_t offset) {
+    const char* message = code == ErrorCode::DivisionByZero ? "Division by zero" : "Integer overflow";
+    throw ExpressionError(string(message) + " @ char: " + to_string(offset), code);
+}
+
+/**
+ * What arithmetic does when a result does not fit the value type: wrap around (two's complement),
+ * throw an ExpressionError with ErrorCode::Overflow, or clamp to the nearest representable value.
+ * Division and remainder by zero are errors under every policy.
+ */
+enum class OverflowPolicy : uint8_t { Wrapping, Checked, Saturating };
+
+/**
+ * Operator codes produced by the tokenizer. NEG is the implicit unary minus
+ * (written "neg" in postfix listings). The same codes are used as bytecode
+ * instructions, together with the bytecode-only instructions that follow NEG.
+ * In bytecode, every arithmetic instruction (ADD through POW, INC, DEC, NEG, SQUARE, and POWI)
+ * is followed by the 4-byte source offset of its operator, for error messages.
+ */
+enum class OpCode : uint8_t {
+    OR, AND, EQ, NE, GT, GE, LT, LE,
+    ADD, SUB, MUL, DIV, MOD, POW,
+    NOT, INC, DEC, NEG,
+    PUSH,    // followed by an integer immediate (4 bytes for int programs, 8 for wider ones)
+    LOAD,    // followed by a 4-byte variable slot index
+    SQUARE,  // x^2 with a constant exponent
+    POWI,    // x^k with a constant exponent, followed by k as a 4-byte immediate
+    RESERVE, // sets aside temporaries at the bottom of the stack, followed by their 4-byte count
+    STORE,   // copies the top value into a temporary, followed by its 4-byte index
+    FETCH,   // pushes a copy of a temporary, followed by its 4-byte index
+    JUMP_IF_ZERO,    // skips the right side of && if the top value is 0, replacing it with 0; 4-byte forward distance
+    JUMP_IF_NONZERO  // skips the right side of || if the top value is nonzero, replacing it with 1; same operand
+};
+
+/**
+ * Checks if a bytecode instruction does arithmetic and so carries a source offset.
+ */
+inline bool isArithmetic(OpCode op) {
+    return (op >= OpCode::ADD && op <= OpCode::POW) || (op >= OpCode::INC && op <= OpCode::NEG) ||
+           op == OpCode::SQUARE || op == OpCode::POWI;
+}
+
+/**
+ * A single element of a tokenized expression. Numbers carry their decoded value,
+ * variables their slot index, operators their OpCode, and every token remembers
+ * the character offset where it starts so errors can point back into the source text.
+ * Numbers with a fraction or an exponent are Real and carry the bit pattern of their double.
+ */
+struct Token {
+    enum class Kind : uint8_t { Number, Real, Variable, Operator, LeftParen, RightParen };
+
+    Kind kind;
+    OpCode op;
+    uint32_t offset;
+    int64_t value;
+};
+
+/**
+ * What a character can start or continue, for the tokenizer. Operator characters are
+ * operators on their own; OperatorPart ones (&, |, =) only as part of a two-character one.
+ */
+enum class CharClass : uint8_t { Other, Space, Digit, Dot, Letter, LeftParen, RightParen, Operator, OperatorPart };
+
+/**
+ * The class of every byte, in the C locale: isspace(), isdigit(), isalpha() or '_'.
+ */
+inline constexpr array<CharClass, 256> charClasses = [] {
+    array<CharClass, 256> classes{};
+    for (unsigned char c : string_view(" \t\n\v\f\r")) classes[c] = CharClass::Space;
+    for (int c = '0'; c <= '9'; ++c) classes[c] = CharClass::Digit;
+    for (int c = 'a'; c <= 'z'; ++c) classes[c] = classes[c - 'a' + 'A'] = CharClass::Letter;
+    for (unsigned char c : string_view("+-*/%^!<>")) classes[c] = CharClass::Operator;
+    for (unsigned char c : string_view("&|=")) classes[c] = CharClass::OperatorPart;
+    classes['_'] = CharClass::Letter;
+    classes['.'] = CharClass::Dot;
+    classes['('] = CharClass::LeftParen;
+    classes[')'] = CharClass::RightParen;
+    return classes;
+}();
+
+/**
+ * Checks for '0' to '9'. Unlike isdigit(), it is defined for negative chars.
+ */
+constexpr bool isDigit(char c) {
+    return charClasses[static_cast<unsigned char>(c)] == CharClass::Digit;
+}
+
+/**
+ * The code of every one-character operator, indexed by its character.
+ */
+inline constexpr array<OpCode, 256> singleCharOperators = [] {
+    array<OpCode, 256> codes{};
+    codes['+'] = OpCode::ADD; codes['-'] = OpCode::SUB;
+    codes['*'] = OpCode::MUL; codes['/'] = OpCode::DIV; codes['%'] = OpCode::MOD;
+    codes['^'] = OpCode::POW; codes['!'] = OpCode::NOT;
+    codes['>'] = OpCode::GT; codes['<'] = OpCode::LT;
+    return codes;
+}();
+
+/**
+ * A perfect hash of the two-character operators: each gets its own slot of a 16-entry table.
+ */
+constexpr size_t twoCharHash(char first, char second) {
+    return (static_cast<unsigned char>(first) ^ (static_cast<unsigned char>(second) >> 3)) & 15;
+}
+
+struct TwoCharOperator {
+    char first;
+    char second;
+    OpCode op;
+};
+
+/**
+ * The two-character operators by twoCharHash(). Empty slots hold '\0', which is never an
+ * operator character, so a match on both characters is a match.
+ */
+inline constexpr array<TwoCharOperator, 16> twoCharOperators = [] {
+    constexpr TwoCharOperator operators[] = {
+        {'|', '|', OpCode::OR}, {'&', '&', OpCode::AND}, {'=', '=', OpCode::EQ}, {'!', '=', OpCode::NE},
+        {'>', '=', OpCode::GE}, {'<', '=', OpCode::LE}, {'+', '+', OpCode::INC}, {'-', '-', OpCode::DEC}
+    };
+    array<TwoCharOperator, 16> table{};
+    for (const TwoCharOperator& entry : operators) {
+        TwoCharOperator& slot = table[twoCharHash(entry.first, entry.second)];
+        if (slot.first != '\0') throw logic_error("twoCharHash() collision");  // stops the build
+        slot = entry;
+    }
+    return table;
+}();
+
+/**
+ * Returns the index of the first byte at or after i that is not whitespace.
+ */
+inline size_t skipSpaces(string_view text, size_t i) {
+    while (i < text.size() && charClasses[static_cast<unsigned char>(text[i])] == CharClass::Space) ++i;
+    return i;
+}
+
+/**
+ * Returns the index of the first byte at or after i that cannot continue a variable name.
+ */
+inline size_t skipNameCharacters(string_view text, size_t i) {
+    while (i < text.size()) {
+        CharClass kind = charClasses[static_cast<unsigned char>(text[i])];
+        if (kind != CharClass::Letter && kind != CharClass::Digit) break;
+        ++i;
+    }
+    return i;
+}
+
+/**
+ * What the constant folder knows about one value on its simulated stack: where the postfix that
+ * computes it starts, whether it is a literal, whether it is known to be 0 or 1, whether computing
+ * it can raise an error, and whether it is a ! applied to a value known to be 0 or 1.
+ */
+struct FoldNode {
+    uint32_t start;
+    bool literal;
+    bool boolean;
+    bool canFail;
+    bool negation;
+};
+
+/**
+ * A distinct subtree of a postfix program, for common subexpression elimination. Identical
+ * subtrees are hash-consed into one node, so each node is an operand or an operator applied to
+ * child nodes. refs counts the references from distinct parent nodes, store is the postfix index
+ * where the node was last computed into its temporary, and temp is that temporary.
+ */
+struct DagNode {
+    Token::Kind kind;
+    OpCode op;
+    int64_t value;
+    uint32_t left;
+    uint32_t right;
+    uint32_t refs;
+    uint32_t store;
+    uint32_t temp;
+};
+
+/**
+ * The variable layout of an expression being compiled: names in slot order, viewing the source
+ * text or the caller's names, and once there are more than linearScanNames of them an
+ * open-addressing hash table of their slot indices + 1, so that looking up a name does not
+ * depend on how many variables there are. If a name is listed twice, the first slot is the one
+ * found.
+ */
+struct VariableLayout {
     /**
-     * A map storing operator precedence values.
-     * Higher values mean higher precedence.
+     * Up to this many names are searched in order, which is faster than hashing the name.
      */
-    unordered_map<string, int> operatorPrecedence = {
-        {"||", 1}, {"&&", 2}, {"==", 3}, {"!=", 3},
-        {">", 4}, {">=", 4}, {"<", 4}, {"<=", 4},
-        {"+", 5}, {"-", 5},
-        {"*", 6}, {"/", 6}, {"%", 6},
-        {"^", 7},
-        {"!", 8}, {"++", 8}, {"--", 8}, {"neg", 8}  // "neg" = unary minus
-    };
+    static constexpr size_t linearScanNames = 4;
+
+    vector<string_view> names;
+    vector<uint32_t> table;  // empty while names are searched in order
+
+    template <typename Iterator>
+    void assign(Iterator first, Iterator last) {
+        names.assign(first, last);
+        rehash();
+    }
+
+    void clear() {
+        names.clear();
+        rehash();
+    }
 
     /**
-     * Checks if an operator is right-associative.
-     * Right-associative operators are evaluated from right to left (e.g., exponentiation).
+     * Drops the names after the first count, e.g. those a failed parse appended.
      */
-    bool isRightAssociative(const string& op) {
-        return op == "^" || op == "!" || op == "++" || op == "--" || op == "neg";
+    void truncate(size_t count) {
+        names.resize(count);
+        rehash();
     }
 
     /**
-     * Determines if a string is a unary operator.
-     * Unary operators operate on a single operand (e.g., -3 or !1).
+     * Returns the slot of name, or names.size() if it is not in the layout.
      */
-    bool isUnaryOperator(const string& op) {
-        return op == "!" || op == "++" || op == "--" || op == "neg";
+    size_t find(string_view name) const {
+        if (table.empty()) return std::find(names.begin(), names.end(), name) - names.begin();
+        uint32_t entry = table[probe(name)];
+        return entry ? entry - 1 : names.size();
     }
 
     /**
-     * Tokenizes an input string into a vector of valid expression elements (tokens),
-     * including numbers, operators, and parentheses. Also handles implicit unary minus.
-     */
-    vector<string> tokenizeExpression(const string& expr) {
-        vector<string> tokens;
-        string number;
-
-        for (size_t i = 0; i < expr.length(); ++i) {
-            char c = expr[i];
-
-            // Skip whitespace
-            if (isspace(c)) continue;
-
-            // Parse numbers
-            if (isdigit(c)) {
-                number += c;
-                while (i + 1 < expr.length() && isdigit(expr[i + 1]))
-                    number += expr[++i];
-                tokens.push_back(number);
-                number.clear();
-            }
-            // Handle operators and parentheses
-            else {
-                string current(1, c);
-
-                // Try to form a two-character operator (e.g., >=, <=, ==, ++, etc.)
-                if (i + 1 < expr.length()) {
-                    string twoChar = current + expr[i + 1];
-                    if (operatorPrecedence.count(twoChar)) {
-                        tokens.push_back(twoChar);
-                        ++i;
-                        continue;
-                    }
-                }
+     * Appends a name that is not in the layout yet and returns its slot.
+     */
+    size_t add(string_view name) {
+        names.push_back(name);
+        if (2 * names.size() > table.size()) {
+            rehash();
+        } else if (!table.empty()) {
+            table[probe(name)] = static_cast<uint32_t>(names.size());
+        }
+        return names.size() - 1;
+    }
 
-                // If '-' is at the beginning or after a left parenthesis or another operator,
-                // treat it as unary negative (e.g., -3 becomes "neg 3")
-                if (current == "-" && (tokens.empty() || tokens.back() == "(" || operatorPrecedence.count(tokens.back()))) {
-                    tokens.push_back("neg");
-                } else {
-                    tokens.push_back(current);
-                }
-            }
+private:
+    /**
+     * Returns the bucket holding name, or the empty bucket where it would go.
+     */
+    size_t probe(string_view name) const {
+        size_t mask = table.size() - 1;
+        size_t bucket = hash<string_view>{}(name) & mask;
+        while (table[bucket] != 0 && names[table[bucket] - 1] != name) bucket = (bucket + 1) & mask;
+        return bucket;
+    }
+
+    /**
+     * Sizes the table to at least twice the names, keeping its capacity, and fills it, or
+     * empties it if there are few enough names to search in order.
+     */
+    void rehash() {
+        if (names.size() <= linearScanNames) {
+            table.clear();
+            return;
         }
+        size_t capacity = 16;
+        while (capacity < 2 * names.size()) capacity *= 2;
+        table.assign(capacity, 0);
+        for (size_t slot = 0; slot < names.size(); ++slot) {
+            size_t bucket = probe(names[slot]);
+            if (table[bucket] == 0) table[bucket] = static_cast<uint32_t>(slot + 1);
+        }
+    }
+};
+
+/**
+ * Reusable buffers for compiling one expression. Keeping one per thread means compiling a
+ * stream of expressions stops allocating once the buffers have grown to fit.
+ */
+struct CompileScratch {
+    vector<Token> tokens;
+    vector<Token> postfix;
+    vector<Token> operators;   // the shunting-yard operator stack
+    vector<FoldNode> foldNodes;  // the constant folder's value stack
+    vector<DagNode> nodes;       // hash-consed subtrees
+    vector<uint32_t> nodeTable;  // open-addressing hash table of node indices + 1
+    vector<uint32_t> tokenNodes, tokenStarts, regions;   // per postfix token
+    vector<uint32_t> outermost, enclosed, fetched;       // per postfix token
+    vector<uint32_t> rightSides;                         // per postfix token
+    vector<uint32_t> operandStack;  // postfix token indices of the values on a simulated stack
+    vector<Token> shared;        // the postfix program with shared subtrees replaced or jumps inserted
+    VariableLayout variables;
+    vector<uint8_t> code;
+    vector<int> values;        // value stack for programs too deep for the inline buffer
+};
+
+/**
+ * Overflow-detecting arithmetic on any of the value types. Each stores the result wrapped to
+ * the value type and returns true if the exact result did not fit. GCC and Clang provide these
+ * as builtins; the fallbacks compute the wrapped result in unsigned arithmetic.
+ */
+template <typename Value>
+bool addOverflows(Value left, Value right, Value& sum) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_add_overflow(left, right, &sum);
+#else
+    using Unsigned = make_unsigned_t<Value>;
+    sum = static_cast<Value>(static_cast<Unsigned>(left) + static_cast<Unsigned>(right));
+    return ((left ^ sum) & (right ^ sum)) < 0;
+#endif
+}
+
+template <typename Value>
+bool subtractOverflows(Value left, Value right, Value& difference) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_sub_overflow(left, right, &difference);
+#else
+    using Unsigned = make_unsigned_t<Value>;
+    difference = static_cast<Value>(static_cast<Unsigned>(left) - static_cast<Unsigned>(right));
+    return ((left ^ right) & (left ^ difference)) < 0;
+#endif
+}
+
+template <typename Value>
+bool multiplyOverflows(Value left, Value right, Value& product) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_mul_overflow(left, right, &product);
+#else
+    using Unsigned = make_unsigned_t<Value>;
+    product = static_cast<Value>(static_cast<Unsigned>(left) * static_cast<Unsigned>(right));
+    return left != 0 && ((left == -1 && right == numeric_limits<Value>::min()) || product / left != right);
+#endif
+}
+
+/**
+ * Floating-point arithmetic rounds instead of overflowing (to infinity at worst), so the double
+ * overloads never report overflow.
+ */
+inline bool addOverflows(double left, double right, double& sum) {
+    sum = left + right;
+    return false;
+}
+
+inline bool subtractOverflows(double left, double right, double& difference) {
+    difference = left - right;
+    return false;
+}
+
+inline bool multiplyOverflows(double left, double right, double& product) {
+    product = left * right;
+    return false;
+}
+
+/**
+ * The overflow policies as types, so the interpreters can be instantiated per policy and the
+ * overflow handling of the unused policies compiles away. overflow() is called with the wrapped
+ * result when an operation overflows and the sign of the exact result; it may replace the result,
+ * and returns true if evaluation must fail. resolve() is its branch-free form for block kernels:
+ * overflowMask has the sign bit set if the operation overflowed, and the returned mask has it
+ * set if evaluation must fail.
+ */
+struct WrappingArithmetic {
+    static constexpr bool canFail = false;
+
+    template <typename Value>
+    static bool overflow(Value&, bool) { return false; }
+
+    template <typename Value>
+    static Value resolve(Value& result, Value wrapped, Value, Value) {
+        result = wrapped;
+        return 0;
+    }
+};
+
+struct CheckedArithmetic {
+    static constexpr bool canFail = true;
+
+    template <typename Value>
+    static bool overflow(Value&, bool) { return true; }
+
+    template <typename Value>
+    static Value resolve(Value& result, Value wrapped, Value overflowMask, Value) {
+        result = wrapped;
+        return overflowMask;
+    }
+};
+
+struct SaturatingArithmetic {
+    static constexpr bool canFail = false;
 
-        return tokens;
+    template <typename Value>
+    static bool overflow(Value& result, bool negative) {
+        result = negative ? numeric_limits<Value>::min() : numeric_limits<Value>::max();
+        return false;
     }
 
+    template <typename Value>
+    static Value resolve(Value& result, Value wrapped, Value overflowMask, Value saturated) {
+        result = overflowMask < 0 ? saturated : wrapped;
+        return 0;
+    }
+};
+
+/**
+ * BigInt: An arbitrary-precision signed integer, for expressions whose intermediate values do not
+ * fit any machine type. Values that fit in an int64_t are stored inline and use overflow-checked
+ * machine arithmetic; a result that does not fit spills to a heap-allocated magnitude of 32-bit
+ * limbs (least significant first) with a separate sign, and moves back inline once it fits again.
+ * Products of long operands use Karatsuba multiplication.
+ *
+ * The arithmetic functions follow the shape of addOverflows() and friends, so the interpreter
+ * runs BigInt programs unchanged; they only report overflow for results longer than maxBits.
+ */
+class BigInt {
+public:
     /**
-     * Performs error checking on the list of tokens to identify malformed expressions.
-     * Checks for issues like consecutive operators, misplaced parentheses, and division by zero.
+     * Results longer than this many bits are reported as overflow, so a rule like 9 ^ 9 ^ 9
+     * fails instead of exhausting memory.
      */
-    void validateTokenSequence(const vector<string>& tokens) {
-        for (size_t i = 0; i < tokens.size(); ++i) {
-            const string& token = tokens[i];
-            const string& prev = (i > 0) ? tokens[i - 1] : "";
-            const string& next = (i + 1 < tokens.size()) ? tokens[i + 1] : "";
+    static constexpr size_t maxBits = size_t(1) << 20;
 
-            // Can't start with a closing parenthesis
-            if (token == ")" && i == 0)
-                throw ExpressionError("Expression can't start with a closing parenthesis @ char: 0");
+    BigInt(int64_t value = 0) : small(value) {}
 
-            // Can't start with a binary operator
-            if (operatorPrecedence.count(token) && !isUnaryOperator(token) && i == 0)
-                throw ExpressionError("Expression can't start with a binary operator @ char: 0");
+    explicit operator bool() const { return !limbs.empty() || small != 0; }
 
-            // Two binary operators in a row (e.g., "3 && && 4")
-            if (operatorPrecedence.count(token) && !isUnaryOperator(token) &&
-                operatorPrecedence.count(prev) && !isUnaryOperator(prev))
-                throw ExpressionError("Two binary operators in a row @ char: " + to_string(i));
+    /**
+     * Returns true while the value is stored inline, i.e. fits in an int64_t.
+     */
+    bool isInline() const { return limbs.empty(); }
+
+    /**
+     * Returns the value in decimal.
+     */
+    string toString() const {
+        if (limbs.empty()) return to_string(small);
 
-            // Two numbers in a row (e.g., "4 5")
-            if (isdigit(token[0]) && !prev.empty() && isdigit(prev[0]))
-                throw ExpressionError("Two operands in a row @ char: " + to_string(i));
+        // Peel off nine decimal digits at a time, least significant first.
+        Magnitude rest = limbs;
+        vector<uint32_t> chunks;
+        while (!rest.empty()) {
+            uint64_t remainder = 0;
+            for (size_t i = rest.size(); i-- > 0; ) {
+                uint64_t current = remainder << 32 | rest[i];
+                rest[i] = static_cast<uint32_t>(current / 1000000000);
+                remainder = current % 1000000000;
+            }
+            trim(rest);
+            chunks.push_back(static_cast<uint32_t>(remainder));
+        }
 
-            // A unary operator directly followed by a binary operator (e.g., ++ < 5)
-            if (isUnaryOperator(token) && !next.empty() && operatorPrecedence.count(next) && !isUnaryOperator(next))
-                throw ExpressionError("A unary operand can’t be followed by a binary operator @ char: " + to_string(i + 1));
+        string text = negative ? "-" : "";
+        text += to_string(chunks.back());
+        for (size_t i = chunks.size() - 1; i-- > 0; ) {
+            string chunk = to_string(chunks[i]);
+            text.append(9 - chunk.size(), '0');
+            text += chunk;
+        }
+        return text;
+    }
+
+    friend bool addOverflows(const BigInt& left, const BigInt& right, BigInt& sum) {
+        int64_t inlineSum;
+        if (left.limbs.empty() && right.limbs.empty() && !addOverflows(left.small, right.small, inlineSum)) {
+            sum = inlineSum;
+            return false;
+        }
+        sum = addSigned(left.magnitude(), left.isNegative(), right.magnitude(), right.isNegative());
+        return sum.bitLength() > maxBits;
+    }
+
+    friend bool subtractOverflows(const BigInt& left, const BigInt& right, BigInt& difference) {
+        int64_t inlineDifference;
+        if (left.limbs.empty() && right.limbs.empty() && !subtractOverflows(left.small, right.small, inlineDifference)) {
+            difference = inlineDifference;
+            return false;
+        }
+        difference = addSigned(left.magnitude(), left.isNegative(), right.magnitude(), !right.isNegative());
+        return difference.bitLength() > maxBits;
+    }
+
+    friend bool multiplyOverflows(const BigInt& left, const BigInt& right, BigInt& product) {
+        int64_t inlineProduct;
+        if (left.limbs.empty() && right.limbs.empty() && !multiplyOverflows(left.small, right.small, inlineProduct)) {
+            product = inlineProduct;
+            return false;
         }
+        if (left.bitLength() + right.bitLength() > maxBits + 1) return true;
+        product = fromMagnitude(multiplyMagnitudes(left.magnitude(), right.magnitude()),
+                                left.isNegative() != right.isNegative());
+        return product.bitLength() > maxBits;
     }
 
     /**
-     * Converts infix tokens to postfix (Reverse Polish Notation) using the Shunting Yard Algorithm.
+     * Computes base^exponent with the same rules as the fixed-width types: a negative exponent
+     * gives 1 or -1 for a base of 1 or -1 and 0 for any other base, which must be nonzero.
      */
-    vector<string> convertToPostfix(const vector<string>& tokens) {
-        vector<string> output;
-        stack<string> operators;
+    friend bool powerOverflows(const BigInt& base, const BigInt& exponent, BigInt& result) {
+        if (exponent.isNegative() || base == 0 || base == 1 || base == -1) {
+            bool odd = exponent.limbs.empty() ? (exponent.small & 1) != 0 : (exponent.limbs[0] & 1) != 0;
+            if (exponent == 0) result = 1;
+            else if (base == 0 || base == 1) result = base;
+            else if (base == -1) result = odd ? -1 : 1;
+            else result = 0;
+            return false;
+        }
 
-        for (const string& token : tokens) {
-            if (isdigit(token[0])) {
-                output.push_back(token);
-            } else if (token == "(") {
-                operators.push(token);
-            } else if (token == ")") {
-                while (!operators.empty() && operators.top() != "(") {
-                    output.push_back(operators.top());
-                    operators.pop();
-                }
-                if (!operators.empty()) operators.pop(); // Remove the '('
-            } else {
-                while (!operators.empty() && operators.top() != "(" &&
-                       ((isRightAssociative(token) && operatorPrecedence[token] < operatorPrecedence[operators.top()]) ||
-                        (!isRightAssociative(token) && operatorPrecedence[token] <= operatorPrecedence[operators.top()]))) {
-                    output.push_back(operators.top());
-                    operators.pop();
-                }
-                operators.push(token);
+        // |base| >= 2, so the result has more than (bitLength(base) - 1) * exponent bits.
+        if (!exponent.limbs.empty() || static_cast<uint64_t>(exponent.small) > maxBits ||
+            (base.bitLength() - 1) * static_cast<uint64_t>(exponent.small) >= maxBits)
+            return true;
+
+        uint64_t bits = static_cast<uint64_t>(exponent.small);
+        BigInt factor = base;
+        result = 1;
+        for (;;) {
+            if ((bits & 1) && multiplyOverflows(result, factor, result)) return true;
+            bits >>= 1;
+            if (bits == 0) return false;
+            if (multiplyOverflows(factor, factor, factor)) return true;
+        }
+    }
+
+    /**
+     * Division and remainder truncate towards zero like the built-in operators.
+     * The divisor must be nonzero.
+     */
+    friend BigInt operator/(const BigInt& left, const BigInt& right) {
+        if (left.limbs.empty() && right.limbs.empty() && !(left.small == INT64_MIN && right.small == -1))
+            return left.small / right.small;
+        Magnitude quotient, remainder;
+        divideMagnitudes(left.magnitude(), right.magnitude(), quotient, remainder);
+        return fromMagnitude(move(quotient), left.isNegative() != right.isNegative());
+    }
+
+    friend BigInt operator%(const BigInt& left, const BigInt& right) {
+        if (left.limbs.empty() && right.limbs.empty())
+            return right.small == -1 ? 0 : left.small % right.small;
+        Magnitude quotient, remainder;
+        divideMagnitudes(left.magnitude(), right.magnitude(), quotient, remainder);
+        return fromMagnitude(move(remainder), left.isNegative());
+    }
+
+    friend bool operator==(const BigInt& left, const BigInt& right) {
+        if (left.limbs.empty() || right.limbs.empty())
+            return left.limbs.empty() && right.limbs.empty() && left.small == right.small;
+        return left.negative == right.negative && left.limbs == right.limbs;
+    }
+
+    friend strong_ordering operator<=>(const BigInt& left, const BigInt& right) {
+        if (left.limbs.empty() && right.limbs.empty()) return left.small <=> right.small;
+        bool negative = left.isNegative();
+        if (negative != right.isNegative()) return negative ? strong_ordering::less : strong_ordering::greater;
+        int order = compareMagnitudes(left.magnitude(), right.magnitude());
+        return (negative ? -order : order) <=> 0;
+    }
+
+    friend ostream& operator<<(ostream& out, const BigInt& value) {
+        return out << value.toString();
+    }
+
+private:
+    using Magnitude = vector<uint32_t>;
+
+    /**
+     * Operands shorter than this many limbs are multiplied with the schoolbook method, which
+     * beats Karatsuba's extra additions at that size.
+     */
+    static constexpr size_t karatsubaThreshold = 32;
+
+    int64_t small = 0;      // the value while limbs is empty
+    bool negative = false;  // the sign while limbs is not empty
+    Magnitude limbs;        // the magnitude if it does not fit in small, otherwise empty
+
+    bool isNegative() const { return limbs.empty() ? small < 0 : negative; }
+
+    Magnitude magnitude() const {
+        if (!limbs.empty()) return limbs;
+        uint64_t value = small < 0 ? 0 - static_cast<uint64_t>(small) : static_cast<uint64_t>(small);
+        Magnitude result;
+        if (value != 0) result.push_back(static_cast<uint32_t>(value));
+        if (value >> 32) result.push_back(static_cast<uint32_t>(value >> 32));
+        return result;
+    }
+
+    size_t bitLength() const {
+        if (limbs.empty()) return bit_width(small < 0 ? 0 - static_cast<uint64_t>(small) : static_cast<uint64_t>(small));
+        return (limbs.size() - 1) * 32 + bit_width(limbs.back());
+    }
+
+    /**
+     * Builds a value from a sign and magnitude, storing it inline if it fits.
+     */
+    static BigInt fromMagnitude(Magnitude magnitude, bool negative) {
+        trim(magnitude);
+        BigInt result;
+        if (magnitude.size() <= 2) {
+            uint64_t value = magnitude.empty() ? 0 : magnitude[0];
+            if (magnitude.size() == 2) value |= static_cast<uint64_t>(magnitude[1]) << 32;
+            if (value <= static_cast<uint64_t>(INT64_MAX) || (negative && value == static_cast<uint64_t>(INT64_MAX) + 1)) {
+                result.small = negative ? static_cast<int64_t>(0 - value) : static_cast<int64_t>(value);
+                return result;
             }
         }
+        result.negative = negative;
+        result.limbs = move(magnitude);
+        return result;
+    }
 
-        // Pop remaining operators
-        while (!operators.empty()) {
-            output.push_back(operators.top());
-            operators.pop();
+    static BigInt addSigned(const Magnitude& left, bool leftNegative, const Magnitude& right, bool rightNegative) {
+        if (leftNegative == rightNegative) {
+            Magnitude sum(max(left.size(), right.size()) + 1);
+            copy(left.begin(), left.end(), sum.begin());
+            addInto(sum.data(), sum.size(), right.data(), right.size());
+            return fromMagnitude(move(sum), leftNegative);
         }
+        if (compareMagnitudes(left, right) < 0) return addSigned(right, rightNegative, left, leftNegative);
+        Magnitude difference = left;
+        subtractInto(difference.data(), difference.size(), right.data(), right.size());
+        return fromMagnitude(move(difference), leftNegative);
+    }
+
+    static void trim(Magnitude& magnitude) {
+        while (!magnitude.empty() && magnitude.back() == 0) magnitude.pop_back();
+    }
+
+    static size_t trimmedSize(const uint32_t* limbs, size_t size) {
+        while (size > 0 && limbs[size - 1] == 0) --size;
+        return size;
+    }
 
-        return output;
+    static int compareMagnitudes(const Magnitude& left, const Magnitude& right) {
+        if (left.size() != right.size()) return left.size() < right.size() ? -1 : 1;
+        for (size_t i = left.size(); i-- > 0; ) {
+            if (left[i] != right[i]) return left[i] < right[i] ? -1 : 1;
+        }
+        return 0;
     }
 
     /**
-     * Applies a binary operator to two integer operands.
+     * Adds source into target in place; the sum must fit in targetSize limbs.
      */
-    int calculateBinaryOperation(const string& op, int left, int right) {
-        if (op == "+") return left + right;
-        if (op == "-") return left - right;
-        if (op == "*") return left * right;
-        if (op == "/") {
-            if (right == 0) throw ExpressionError("Division by zero");
-            return left / right;
+    static void addInto(uint32_t* target, size_t targetSize, const uint32_t* source, size_t sourceSize) {
+        uint64_t carry = 0;
+        size_t i = 0;
+        for (; i < sourceSize; ++i) {
+            carry += static_cast<uint64_t>(target[i]) + source[i];
+            target[i] = static_cast<uint32_t>(carry);
+            carry >>= 32;
+        }
+        for (; carry != 0 && i < targetSize; ++i) {
+            carry += target[i];
+            target[i] = static_cast<uint32_t>(carry);
+            carry >>= 32;
         }
-        if (op == "%") return left % right;
-        if (op == "^") return pow(left, right);
-        if (op == "==") return left == right;
-        if (op == "!=") return left != right;
-        if (op == ">") return left > right;
-        if (op == "<") return left < right;
-        if (op == ">=") return left >= right;
-        if (op == "<=") return left <= right;
-        if (op == "&&") return left && right;
-        if (op == "||") return left || right;
-
-        throw ExpressionError("Unknown binary operator: " + op);
     }
 
     /**
-     * Applies a unary operator to a single integer operand.
+     * Subtracts source from target in place; target must not be smaller.
      */
-    int calculateUnaryOperation(const string& op, int operand) {
-        if (op == "!") return !operand;
-        if (op == "++") return operand + 1;
-        if (op == "--") return operand - 1;
-        if (op == "neg") return -operand;
+    static void subtractInto(uint32_t* target, size_t targetSize, const uint32_t* source, size_t sourceSize) {
+        uint64_t borrow = 0;
+        size_t i = 0;
+        for (; i < sourceSize; ++i) {
+            uint64_t difference = static_cast<uint64_t>(target[i]) - source[i] - borrow;
+            target[i] = static_cast<uint32_t>(difference);
+            borrow = difference >> 63;
+        }
+        for (; borrow != 0 && i < targetSize; ++i) {
+            borrow = target[i] == 0;
+            --target[i];
+        }
+    }
 
-        throw ExpressionError("Unknown unary operator: " + op);
+    static Magnitude multiplyMagnitudes(const Magnitude& left, const Magnitude& right) {
+        if (left.empty() || right.empty()) return {};
+        Magnitude product(left.size() + right.size());
+        multiplyInto(left.data(), left.size(), right.data(), right.size(), product.data());
+        return product;
     }
 
     /**
-     * Evaluates a postfix expression using a value stack.
+     * Stores the product of a (n limbs) and b (m limbs) in product, which has n + m limbs.
      */
-    int evaluatePostfixExpression(const vector<string>& postfix) {
-        stack<int> values;
+    static void multiplyInto(const uint32_t* a, size_t n, const uint32_t* b, size_t m, uint32_t* product) {
+        if (n < m) {
+            swap(a, b);
+            swap(n, m);
+        }
+        fill(product, product + n + m, 0);
 
-        for (const string& token : postfix) {
-            if (isdigit(token[0])) {
-                values.push(stoi(token));
-            } else if (isUnaryOperator(token)) {
-                if (values.empty()) throw ExpressionError("Missing operand for unary operator");
-                int operand = values.top(); values.pop();
-                values.push(calculateUnaryOperation(token, operand));
-            } else {
-                if (values.size() < 2) throw ExpressionError("Missing operands for binary operator");
-                int right = values.top(); values.pop();
-                int left = values.top(); values.pop();
-                values.push(calculateBinaryOperation(token, left, right));
+        if (m < karatsubaThreshold) {
+            for (size_t i = 0; i < m; ++i) {
+                uint64_t carry = 0;
+                for (size_t j = 0; j < n; ++j) {
+                    carry += static_cast<uint64_t>(a[j]) * b[i] + product[i + j];
+                    product[i + j] = static_cast<uint32_t>(carry);
+                    carry >>= 32;
+                }
+                product[i + n] = static_cast<uint32_t>(carry);
+            }
+            return;
+        }
+
+        // Very unequal lengths: multiply b by m-limb slices of a, which keeps the halves balanced.
+        if (2 * m <= n) {
+            vector<uint32_t> partial(2 * m);
+            for (size_t i = 0; i < n; i += m) {
+                size_t slice = min(m, n - i);
+                multiplyInto(a + i, slice, b, m, partial.data());
+                addInto(product + i, n + m - i, partial.data(), slice + m);
             }
+            return;
         }
 
-        if (values.size() != 1) throw ExpressionError("Expression evaluation error: leftover operands");
-        return values.top();
+        // Karatsuba: with a = a1 B^k + a0 and b = b1 B^k + b0, the middle term
+        // a1 b0 + a0 b1 is (a0 + a1)(b0 + b1) - a0 b0 - a1 b1, so three products suffice.
+        size_t k = n / 2;
+        multiplyInto(a, k, b, k, product);                          // a0 b0 in the low 2k limbs
+        multiplyInto(a + k, n - k, b + k, m - k, product + 2 * k);  // a1 b1 in the rest
+
+        Magnitude sumA(n - k + 1), sumB(max(k, m - k) + 1);
+        copy(a + k, a + n, sumA.begin());
+        addInto(sumA.data(), sumA.size(), a, k);
+        copy(b, b + k, sumB.begin());
+        addInto(sumB.data(), sumB.size(), b + k, m - k);
+
+        Magnitude middle(sumA.size() + sumB.size());
+        multiplyInto(sumA.data(), sumA.size(), sumB.data(), sumB.size(), middle.data());
+        subtractInto(middle.data(), middle.size(), product, trimmedSize(product, 2 * k));
+        subtractInto(middle.data(), middle.size(), product + 2 * k, trimmedSize(product + 2 * k, n + m - 2 * k));
+        addInto(product + k, n + m - k, middle.data(), trimmedSize(middle.data(), middle.size()));
     }
 
-public:
     /**
-     * Main function to be called from main().
-     * Parses, validates, and evaluates a complete infix expression.
+     * Long division of magnitudes (Knuth's algorithm D, in the form of Hacker's Delight).
+     * The divisor must be nonzero.
      */
-    int evaluate(const string& expression) {
-        vector<string> tokens = tokenizeExpression(expression);
-        validateTokenSequence(tokens);
-        vector<string> postfix = convertToPostfix(tokens);
-        return evaluatePostfixExpression(postfix);
+    static void divideMagnitudes(const Magnitude& dividend, const Magnitude& divisor, Magnitude& quotient, Magnitude& remainder) {
+        if (compareMagnitudes(dividend, divisor) < 0) {
+            quotient.clear();
+            remainder = dividend;
+            return;
+        }
+
+        size_t n = divisor.size(), m = dividend.size() - n;
+        quotient.assign(m + 1, 0);
+        if (n == 1) {
+            uint64_t rest = 0;
+            for (size_t i = dividend.size(); i-- > 0; ) {
+                uint64_t current = rest << 32 | dividend[i];
+                quotient[i] = static_cast<uint32_t>(current / divisor[0]);
+                rest = current % divisor[0];
+            }
+            remainder.assign(1, static_cast<uint32_t>(rest));
+            trim(quotient);
+            trim(remainder);
+            return;
+        }
+
+        // Normalize so the divisor's top limb has its high bit set, which keeps each
+        // quotient-digit estimate at most two too large.
+        int shift = countl_zero(divisor.back());
+        Magnitude v(n), u(dividend.size() + 1);
+        for (size_t i = n; i-- > 0; )
+            v[i] = divisor[i] << shift | (shift && i > 0 ? divisor[i - 1] >> (32 - shift) : 0);
+        u[dividend.size()] = shift ? dividend.back() >> (32 - shift) : 0;
+        for (size_t i = dividend.size(); i-- > 0; )
+            u[i] = dividend[i] << shift | (shift && i > 0 ? dividend[i - 1] >> (32 - shift) : 0);
+
+        for (size_t j = m + 1; j-- > 0; ) {
+            uint64_t numerator = static_cast<uint64_t>(u[j + n]) << 32 | u[j + n - 1];
+            uint64_t estimate = numerator / v[n - 1], rest = numerator % v[n - 1];
+            while (estimate >> 32 || estimate * v[n - 2] > (rest << 32 | u[j + n - 2])) {
+                --estimate;
+                rest += v[n - 1];
+                if (rest >> 32) break;
+            }
+
+            // Multiply and subtract; add back once if the estimate was still one too large.
+            int64_t borrow = 0, difference;
+            for (size_t i = 0; i < n; ++i) {
+                uint64_t product = estimate * v[i];
+                difference = static_cast<int64_t>(u[i + j]) - borrow - static_cast<int64_t>(product & 0xFFFFFFFF);
+                u[i + j] = static_cast<uint32_t>(difference);
+                borrow = static_cast<int64_t>(product >> 32) - (difference >> 32);
+            }
+            difference = static_cast<int64_t>(u[j + n]) - borrow;
+            u[j + n] = static_cast<uint32_t>(difference);
+
+            if (difference < 0) {
+                --estimate;
+                uint64_t carry = 0;
+                for (size_t i = 0; i < n; ++i) {
+                    carry += static_cast<uint64_t>(u[i + j]) + v[i];
+                    u[i + j] = static_cast<uint32_t>(carry);
+                    carry >>= 32;
+                }
+                u[j + n] += static_cast<uint32_t>(carry);
+            }
+            quotient[j] = static_cast<uint32_t>(estimate);
+        }
+
+        remainder.resize(n);
+        for (size_t i = 0; i < n; ++i)
+            remainder[i] = u[i] >> shift | (shift ? u[i + 1] << (32 - shift) : 0);
+        trim(quotient);
+        trim(remainder);
     }
 };
 
+/**
+ * Fixed-width value types wrap, saturate, and vectorize; BigInt does none of these.
+ */
+template <typename Value>
+constexpr bool isFixedWidth = true;
+
+template <>
+inline constexpr bool isFixedWidth<BigInt> = false;
+
+class MathLogicEvaluator;
+class NativeCode;
+
+/**
+ * BasicCompiledExpression: An immutable bytecode program produced by MathLogicEvaluator::compile().
+ * The expression has already been tokenized, validated, and converted, so run() only evaluates it.
+ *
+ * Value is the type every value is computed in (int, int64_t, __int128, BigInt, or double), fixed
+ * per program when it is compiled. The interpreter is instantiated once per type, so int programs
+ * keep their native-width arithmetic, and only int programs are translated to machine code.
+ * Decimal literals such as 1.5 or 2e-3 are only accepted in double programs, where / and % are
+ * floating-point division and fmod().
+ *
+ * The bytecode is the postfix form packed into bytes: one OpCode per instruction, with PUSH,
+ * LOAD, and POWI followed by their immediates. Operators pop their operands and push the result.
+ */
+template <typename Value>
+class BasicCompiledExpression {
+private:
+    friend class MathLogicEvaluator;
+
+    /**
+     * tests/test.h and bench/fold_bench.cpp read the instructions of compiled programs.
+     */
+    friend struct ProgramTest;
+
+    /**
+     * Type of PUSH immediates. Literals are decoded as int64_t, so wider programs need 8 bytes,
+     * and floating-point programs store them as doubles.
+     */
+    using Immediate = conditional_t<is_floating_point_v<Value>, double,
+                                    conditional_t<(sizeof(Value) > sizeof(int32_t)), int64_t, int32_t>>;
+
+    /**
+     * Programs whose stack never grows beyond this many values run on a buffer on the C++ stack,
+     * deeper ones on stackArena(). BigInt programs always use the arena, where values keep their
+     * limbs from run to run instead of being constructed and destroyed every time.
+     */
+    static constexpr uint32_t inlineStackDepth = isFixedWidth<Value> ? 64 : 0;
+
+    /**
+     * Returns the calling thread's value buffer for Value programs, grown to at least size
+     * values. Up to keptArenaBytes of it is kept between calls, so only the first run of a
+     * deeper program than any before it allocates. No caller holds it across another call
+     * that uses it.
+     */
+    static Value* stackArena(size_t size) {
+        vector<Value>& values = threadValues();
+        if (values.size() < size) values.resize(size);
+        return values.data();
+    }
+
+    static vector<Value>& threadValues() {
+        thread_local vector<Value> values;
+        return values;
+    }
+
+    /**
+     * The most memory stackArena() keeps once the call that grew it returns, enough for
+     * runColumns() on int programs about 4000 values deep. A larger buffer is released then,
+     * so one very deep program does not pin its memory to the thread.
+     */
+    static constexpr size_t keptArenaBytes = size_t(1) << 22;
+
+    /**
+     * Releases the calling thread's value buffer if it is larger than keptArenaBytes. Called as
+     * run(), runColumns() and filter() return, when nothing holds the buffer any more.
+     */
+    static void trimStackArena() {
+        vector<Value>& values = threadValues();
+        if (values.size() * sizeof(Value) > keptArenaBytes) vector<Value>().swap(values);
+    }
+
+    /**
+     * Returns the calling thread's buffer of 2 * blockRows row indices for right sides nested
+     * level deep in executeOpenRows(). Each level keeps its own buffer, so an inner right side
+     * never moves the rows of the one around it. A nested right side runs on fewer rows than
+     * the one around it, so there are at most blockRows + 1 levels, about 0.5 MB in all.
+     */
+    static uint32_t* openRowArena(size_t level) {
+        thread_local vector<vector<uint32_t>> levels;
+        if (levels.size() <= level) levels.resize(level + 1);
+        if (levels[level].empty()) levels[level].resize(2 * blockRows);
+        return levels[level].data();
+    }
+
+    /**
+     * Number of rows runColumns() pushes through each instruction at a time. Small enough
+     * for a whole stack of blocks to stay in cache, large enough to amortize dispatch.
+     */
+    static constexpr size_t blockRows = 256;
+
+    /**
+     * The packed bytecode program.
+     */
+    vector<uint8_t> code;
+
+    /**
+     * Variable names in slot order; LOAD instructions refer to them by index.
+     */
+    vector<string> variableNames;
+
+    /**
+     * The deepest the value stack gets while running the program, computed at compile time,
+     * including the temporaries of shared subexpressions at its bottom.
+     */
+    uint32_t maxStackDepth = 0;
+
+    /**
+     * The number of blocks runColumns() needs, which blockStackDepth() computes.
+     */
+    uint32_t maxBlockDepth = 0;
+
+    /**
+     * Number of runs after which the program is translated to native code (0 = never).
+     */
+    uint32_t jitThreshold = 0;
+
+    /**
+     * What arithmetic does on overflow, fixed when the program is compiled.
+     */
+    OverflowPolicy overflowPolicy = OverflowPolicy::Checked;
+
+    /**
+     * Tier-up state shared by all copies of a program: the runs counted so far towards
+     * jitThreshold, and the native code once it exists. Both are atomic so one program can
+     * be run from many threads; they only cache work and never change the result of run().
+     */
+    struct TierState {
+        atomic<uint32_t> runs{0};
+        atomic<const NativeCode*> native{nullptr};
+        ~TierState();
+    };
+
+    shared_ptr<TierState> tier = make_shared<TierState>();
+
+    BasicCompiledExpression(vector<uint8_t> program, uint32_t stackDepth)
+        : code(move(program)), maxStackDepth(stackDepth),
+          maxBlockDepth(blockStackDepth(code.data(), code.data() + code.size())) {}
+
+    /**
+     * Returns the number of immediate bytes following an instruction.
+     */
+    static size_t immediateSize(OpCode op) {
+        if (op == OpCode::PUSH) return sizeof(Immediate);
+        if (op == OpCode::POWI) return 2 * sizeof(int32_t);  // the exponent, then the source offset
+        return (op == OpCode::LOAD || op >= OpCode::RESERVE || isArithmetic(op)) ? sizeof(int32_t) : 0;
+    }
+
+    /**
+     * Returns how many values an instruction pops (PUSH and LOAD pop none and push one).
+     * Jumps count as unary: they test the top value and leave a value in its place.
+     */
+    static int operandCount(OpCode op) {
+        if (op == OpCode::PUSH || op == OpCode::LOAD || op == OpCode::FETCH) return 0;
+        if ((op >= OpCode::NOT && op <= OpCode::NEG) || op == OpCode::SQUARE || op == OpCode::POWI || op == OpCode::STORE ||
+            op >= OpCode::JUMP_IF_ZERO)
+            return 1;
+        return 2;
+    }
+
+    /**
+     * Checks if an instruction can raise an ExpressionError at run time under an overflow policy.
+     */
+    static bool canFail(OpCode op, OverflowPolicy policy) {
+        // / and % fail on a zero divisor, and ^ on zero to a negative power, under every policy.
+        if (op == OpCode::DIV || op == OpCode::MOD || op == OpCode::POW) return true;
+        if (is_floating_point_v<Value> || !isArithmetic(op)) return false;
+        return policy == OverflowPolicy::Checked || !isFixedWidth<Value>;  // BigInt ignores the policy
+    }
+
+    /**
+     * Returns whether any instruction in [pc, end) can raise an error.
+     */
+    bool canFail(const uint8_t* pc, const uint8_t* end) const {
+        for (; pc != end; pc += 1 + immediateSize(static_cast<OpCode>(*pc)))
+            if (canFail(static_cast<OpCode>(*pc), overflowPolicy)) return true;
+        return false;
+    }
+
+    /**
+     * Returns how many blocks executeBlock() may need for the instructions in [pc, end), counting
+     * the temporaries. executeOpenRows() runs a right side of && or || in the blocks above its
+     * left value, after a gathered copy of the temporaries, so every right side a value is
+     * computed in adds the temporaries once more. Each && and || ends exactly one right side.
+     */
+    static uint32_t blockStackDepth(const uint8_t* pc, const uint8_t* end) {
+        uint32_t depth = 0, maxDepth = 0, temps = 0, rightSides = 0;
+        for (; pc != end; pc += 1 + immediateSize(static_cast<OpCode>(*pc))) {
+            OpCode op = static_cast<OpCode>(*pc);
+            if (op == OpCode::RESERVE) {
+                memcpy(&temps, pc + 1, sizeof(temps));
+                depth += temps;
+                maxDepth = max(maxDepth, depth);
+                continue;
+            }
+            if (op == OpCode::JUMP_IF_ZERO || op == OpCode::JUMP_IF_NONZERO) ++rightSides;
+            if (op == OpCode::AND || op == OpCode::OR) --rightSides;
+            int operands = operandCount(op);
+            if (operands == 0) maxDepth = max(maxDepth, ++depth + rightSides * temps);
+            if (operands == 2) --depth;
+        }
+        return maxDepth;
+    }
+
+    /**
+     * Throws the error for the arithmetic instruction whose source offset is at source.
+     */
+    [[noreturn]] static void fail(ErrorCode code, const uint8_t* source) {
+        uint32_t offset;
+        memcpy(&offset, source, sizeof(offset));
+        throwEvaluationError(code, offset);
+    }
+
+    /**
+     * The arithmetic operators under an overflow policy. Each stores its result and returns true
+     * if evaluation must fail with an overflow error. Division and remainder expect a nonzero divisor.
+     * BigInt operands are passed by reference; its functions allow the result to alias them.
+     */
+    using Operand = conditional_t<isFixedWidth<Value>, Value, const Value&>;
+
+    template <typename Policy>
+    static bool add(Operand left, Operand right, Value& sum) {
+        return addOverflows(left, right, sum) && Policy::overflow(sum, right < 0);
+    }
+
+    template <typename Policy>
+    static bool subtract(Operand left, Operand right, Value& difference) {
+        return subtractOverflows(left, right, difference) && Policy::overflow(difference, right > 0);
+    }
+
+    template <typename Policy>
+    static bool multiply(Operand left, Operand right, Value& product) {
+        return multiplyOverflows(left, right, product) && Policy::overflow(product, (left < 0) != (right < 0));
+    }
+
+    template <typename Policy>
+    static bool divide(Operand left, Operand right, Value& quotient) {
+        if constexpr (!is_floating_point_v<Value>) {
+            if (right == -1) return subtract<Policy>(0, left, quotient);  // only the minimum value overflows
+        }
+        quotient = left / right;
+        return false;
+    }
+
+    static Value remainder(Operand left, Operand right) {
+        if constexpr (is_floating_point_v<Value>) return fmod(left, right);
+        else return right == -1 ? 0 : left % right;  // the minimum value % -1 would trap
+    }
+
+    /**
+     * Branch-free + and - for the block kernels, returning the policy's failure mask. Checking
+     * the builtins' overflow flags keeps the loops scalar, so overflow is detected from the signs
+     * instead: a sum overflowed iff it differs in sign from both operands.
+     */
+    template <typename Policy>
+    static Value addInBlock(Value left, Value right, Value& sum) {
+        Value wrapped;
+        addOverflows(left, right, wrapped);
+        Value saturated = (right >> signBit) ^ numeric_limits<Value>::max();  // the minimum if right < 0
+        return Policy::resolve(sum, wrapped, (left ^ wrapped) & (right ^ wrapped), saturated);
+    }
+
+    template <typename Policy>
+    static Value subtractInBlock(Value left, Value right, Value& difference) {
+        Value wrapped;
+        subtractOverflows(left, right, wrapped);
+        Value saturated = (~right >> signBit) ^ numeric_limits<Value>::max();  // the minimum if right > 0
+        return Policy::resolve(difference, wrapped, (left ^ right) & (left ^ wrapped), saturated);
+    }
+
+    static constexpr int signBit = sizeof(Value) * CHAR_BIT - 1;
+
+    /**
+     * Computes base^exponent by repeated squaring. A negative exponent gives the integer part of
+     * 1 / base^-exponent: 1 or -1 for a base of 1 or -1, and 0 for any other base, which must be
+     * nonzero. Wrapped products stay exact modulo 2^bits, so the wrapping policy still gets the
+     * right wrapped power. Floating-point programs use pow(), so a fractional power of a negative
+     * base is NaN.
+     */
+    template <typename Policy>
+    static bool power(Value base, Value exponent, Value& result) {
+        if constexpr (!isFixedWidth<Value>) {
+            return powerOverflows(base, exponent, result);
+        } else if constexpr (is_floating_point_v<Value>) {
+            result = pow(base, exponent);
+            return false;
+        } else {
+            if (exponent < 0) {
+                result = (base == 1 || base == -1) ? ((exponent & 1) ? base : 1) : 0;
+                return false;
+            }
+
+            // Squaring only happens while exponent bits remain, so an overflowing square
+            // always means the final result overflows too.
+            bool negative = base < 0 && (exponent & 1);
+            bool overflow = false;
+            result = 1;
+            for (;;) {
+                if (exponent & 1) overflow |= multiplyOverflows(result, base, result);
+                exponent >>= 1;
+                if (exponent == 0) break;
+                overflow |= multiplyOverflows(base, base, base);
+            }
+            return overflow && Policy::overflow(result, negative);
+        }
+    }
+
+    /**
+     * The interpreter loop over the bytecode in [pc, end). The stack has already been sized to
+     * the program's maximum depth and the program was checked at compile time, so no bounds
+     * checks are needed. The policy is dispatched once here rather than per instruction.
+     */
+    static Value execute(OverflowPolicy policy, const uint8_t* pc, const uint8_t* end, Value* values, const Value* slots);
+
+    template <typename Policy>
+    static Value execute(const uint8_t* pc, const uint8_t* end, Value* values, const Value* slots);
+
+    /**
+     * The block-at-a-time interpreter loop used by runColumns() and filter(). Runs the bytecode
+     * in [pc, end) for rows rows, which are either consecutive from first or, if selection is
+     * set, the listed row indices. values holds the blocks blockStackDepth() counts for the
+     * code, of blockRows entries each. Returns the block holding the results, of which only the
+     * first rows entries are meaningful.
+     * Unless speculate is set, a right side of && or || that can fail is run on its own for the
+     * rows that need it, with the first temps blocks of values holding the gathered temporaries.
+     */
+    const Value* executeBlock(Value* values, const uint8_t* pc, const uint8_t* end, span<const span<const Value>> columns,
+                              size_t first, const uint32_t* selection, size_t rows) const;
+
+    template <typename Policy>
+    const Value* executeBlock(Value* values, const uint8_t* pc, const uint8_t* end, span<const span<const Value>> columns,
+                              size_t first, const uint32_t* selection, size_t rows, bool speculate, uint32_t temps = 0) const;
+
+    /**
+     * Finishes a && or || whose left values are in the block top by running its right side, in
+     * [pc, end), on its own for just the rows the left side left open: those with a nonzero left
+     * value if open is set, else those with a zero one. Leaves 0 or 1 in top for every row. The
+     * right side runs in the blocks above top. Kept out of executeBlock() so its loop stays tight.
+     */
+    template <typename Policy>
+    void executeOpenRows(Value* values, Value* top, const uint8_t* pc, const uint8_t* end, bool open,
+                         span<const span<const Value>> columns, size_t first, const uint32_t* selection, size_t rows,
+                         uint32_t temps) const;
+
+    /**
+     * The program as filter() walks it, as a tree. code is the bytecode with shared subexpressions
+     * expanded back in place, since filter() evaluates the sides of && and || on different rows;
+     * stackDepth is the stack it needs, which expansion can make deeper than the frame. For
+     * instruction k, offsets[k] is its byte offset and subtreeStart[k] the first instruction of
+     * the subtree it is the root of. failingBefore[k] counts the instructions before k that can
+     * raise an error. offsets and failingBefore have one extra entry marking the end of the code.
+     */
+    struct ProgramTree {
+        vector<uint8_t> code;
+        size_t stackDepth = 0;
+        vector<size_t> offsets;
+        vector<size_t> subtreeStart;
+        vector<size_t> failingBefore;
+
+        bool canFail(size_t root) const {
+            return failingBefore[root + 1] != failingBefore[subtreeStart[root]];
+        }
+    };
+
+    ProgramTree buildProgramTree() const;
+
+    /**
+     * The tree filter() walks, built once when the program is compiled and shared by its copies.
+     * Null for BigInt programs, which filter() does not support, and for the programs evaluate()
+     * caches, which it only runs.
+     */
+    shared_ptr<const ProgramTree> filterTree;
+
+    /**
+     * Narrows selection to the rows for which the subtree rooted at instruction root is nonzero.
+     * If failing is set, it receives the rows that were removed. Both stay in increasing order.
+     */
+    void filterSubtree(const ProgramTree& tree, size_t root, span<const span<const Value>> columns,
+                       Value* values, vector<uint32_t>& selection, vector<uint32_t>* failing) const;
+
+    /**
+     * Checks that there is a long enough column for every variable.
+     */
+    void checkColumns(span<const span<const Value>> columns, size_t rows) const;
+
+    /**
+     * Applies an element-wise operation to a full block. The loop has a fixed trip count and
+     * non-aliasing operands so the compiler turns it into SIMD code.
+     */
+    template <typename Operation>
+    static void applyToBlock(Value* __restrict left, const Value* __restrict right, Operation operation) {
+        for (size_t i = 0; i < blockRows; ++i)
+            left[i] = operation(left[i], right[i]);
+    }
+
+    /**
+     * Applies an arithmetic operator to a block and returns true if any row must fail. operation
+     * stores its result and returns a mask with the sign bit set for failing rows. Full blocks keep
+     * the fixed trip count; under a policy that can fail, a partial block only computes its first
+     * rows rows, so its padding cannot raise errors of its own.
+     */
+    template <typename Policy, typename Operation>
+    static bool applyToBlock(Value* __restrict left, const Value* __restrict right, size_t rows, Operation operation) {
+        Value failed = 0;
+        if (!Policy::canFail || rows == blockRows) {
+            for (size_t i = 0; i < blockRows; ++i) failed |= operation(left[i], right[i], left[i]);
+        } else {
+            for (size_t i = 0; i < rows; ++i) failed |= operation(left[i], right[i], left[i]);
+        }
+        return failed < 0;
+    }
+
+    template <typename Policy, typename Operation>
+    static bool applyToBlock(Value* values, size_t rows, Operation operation) {
+        Value failed = 0;
+        if (!Policy::canFail || rows == blockRows) {
+            for (size_t i = 0; i < blockRows; ++i) failed |= operation(values[i], values[i]);
+        } else {
+            for (size_t i = 0; i < rows; ++i) failed |= operation(values[i], values[i]);
+        }
+        return failed < 0;
+    }
+
+    /**
+     * Translates the bytecode to native code. Returns null (so the interpreter keeps
+     * running the program) when the platform, the value type, or an instruction is not supported.
+     */
+    const NativeCode* compileNative() const;
+
+public:
+    /**
+     * Evaluates the compiled program and returns its result.
+     * slots holds one value per variable, in the order given by variables().
+     */
+    Value run(span<const Value> slots = {}) const;
+
+    /**
+     * Evaluates the program once per row of columnar input and writes one result per row.
+     * columns holds one column per variable (in slot order), each with at least results.size()
+     * values. Rows are processed in blocks, applying each instruction to a whole block at a time.
+     */
+    void runColumns(span<const span<const Value>> columns, span<Value> results) const;
+
+    /**
+     * Returns the indices, in increasing order, of the first rows rows of columnar input for
+     * which the expression is nonzero. Comparisons are evaluated a block at a time, and && and ||
+     * only evaluate their right side for rows the left side has not already decided, so the
+     * right side's errors (e.g. division by zero) are not reported for those rows.
+     */
+    vector<uint32_t> filter(span<const span<const Value>> columns, size_t rows) const;
+
+    /**
+     * Returns the variable names referenced by the expression, in slot order.
+     */
+    const vector<string>& variables() const { return variableNames; }
+
+    /**
+     * Returns the slot index of a variable, or -1 if the expression does not use it.
+     */
+    int slotOf(const string& name) const {
+        auto it = find(variableNames.begin(), variableNames.end(), name);
+        return it == variableNames.end() ? -1 : static_cast<int>(it - variableNames.begin());
+    }
+
+    /**
+     * Returns true once the program has been tiered up to native code.
+     */
+    bool isNative() const { return tier->native.load(memory_order_acquire) != nullptr; }
+};
+
+using CompiledExpression = BasicCompiledExpression<int>;
+using CompiledExpression64 = BasicCompiledExpression<int64_t>;
+#if MATHLOGIC_INT128
+using CompiledExpression128 = BasicCompiledExpression<__int128>;
+#endif
+using CompiledExpressionBig = BasicCompiledExpression<BigInt>;
+using CompiledExpressionDouble = BasicCompiledExpression<double>;
+
+/**
+ * Results of MathLogicEvaluator::evaluateBatch(), in input order. values[i] is only
+ * meaningful when errors[i] is ErrorCode::None.
+ */
+struct BatchResult {
+    vector<int> values;
+    vector<ErrorCode> errors;
+};
+
+/**
+ * WorkRange: The item indices still owned by one batch worker. The owner takes chunks from
+ * the front and idle workers steal the back half, both with a compare-and-swap on the packed
+ * (begin, end) pair, so no locks are needed. Aligned to a cache line to avoid false sharing.
+ */
+class alignas(64) WorkRange {
+public:
+    void assign(uint32_t begin, uint32_t end) {
+        bounds.store(pack(begin, end), memory_order_relaxed);
+    }
+
+    /**
+     * Takes up to size items from the front. Returns false once the range is empty.
+     */
+    bool take(uint32_t size, uint32_t& begin, uint32_t& end) {
+        uint64_t current = bounds.load(memory_order_relaxed);
+        for (;;) {
+            uint32_t first = static_cast<uint32_t>(current >> 32), last = static_cast<uint32_t>(current);
+            if (first >= last) return false;
+            uint32_t next = first + min(size, last - first);
+            if (bounds.compare_exchange_weak(current, pack(next, last), memory_order_relaxed)) {
+                begin = first;
+                end = next;
+                return true;
+            }
+        }
+    }
+
+    /**
+     * Steals the back half of the range (all of it if only one item is left).
+     * Returns false if the range is empty.
+     */
+    bool steal(uint32_t& begin, uint32_t& end) {
+        uint64_t current = bounds.load(memory_order_relaxed);
+        for (;;) {
+            uint32_t first = static_cast<uint32_t>(current >> 32), last = static_cast<uint32_t>(current);
+            if (first >= last) return false;
+            uint32_t middle = first + (last - first) / 2;
+            if (bounds.compare_exchange_weak(current, pack(first, middle), memory_order_relaxed)) {
+                begin = middle;
+                end = last;
+                return true;
+            }
+        }
+    }
+
+private:
+    atomic<uint64_t> bounds{0};
+
+    static uint64_t pack(uint32_t begin, uint32_t end) {
+        return static_cast<uint64_t>(begin) << 32 | end;
+    }
+};
+
+/**
+ * MathLogicEvaluator: A class for parsing and evaluating complex infix expressions
+ * with both arithmetic and logical operators, including error checking.
+ */
+class MathLogicEvaluator {
+private:
+    /**
+     * tests/parser_test.cpp and bench/parser_bench.cpp run the Pratt parser and the three-pass
+     * front end side by side.
+     */
+    friend struct ParserTest;
+
+    /**
+     * Number of runs of a compiled expression before it is translated to native code.
+     * Zero disables the native code tier.
+     */
+    uint32_t jitThreshold = 0;
+
+    /**
+     * What arithmetic does on overflow in expressions compiled by this evaluator.
+     */
+    OverflowPolicy overflowPolicy = OverflowPolicy::Checked;
+
+    /**
+     * A cached program, with the value of cacheClock when it was last used.
+     */
+    struct CacheEntry {
+        string expression;
+        shared_ptr<const CompiledExpression> program;
+        uint64_t lastUse;
+    };
+
+    /**
+     * One shard of the least-recently-used cache of programs compiled by evaluate(), most recent
+     * first. index maps expression text (viewing the string stored in the list node) to its entry.
+     * Expressions are spread over the shards by hash, so threads rarely wait for the same lock.
+     */
+    struct CacheShard {
+        using Entries = list<CacheEntry>;
+
+        mutex lock;
+        Entries entries;
+        unordered_map<string_view, Entries::iterator> index;
+        size_t hits = 0;
+        size_t misses = 0;
+    };
+
+    static constexpr size_t cacheShardCount = 16;
+    mutable array<CacheShard, cacheShardCount> cacheShards;
+    mutable atomic<uint64_t> cacheClock{0};  // orders uses across shards, for reshard()
+    size_t cacheCapacity = 1024;
+
+    /**
+     * Returns the precedence of an operator.
+     * Higher values mean higher precedence.
+     */
+    static int operatorPrecedence(OpCode op) {
+        switch (op) {
+            case OpCode::OR: return 1;
+            case OpCode::AND: return 2;
+            case OpCode::EQ: case OpCode::NE: return 3;
+            case OpCode::GT: case OpCode::GE: case OpCode::LT: case OpCode::LE: return 4;
+            case OpCode::ADD: case OpCode::SUB: return 5;
+            case OpCode::MUL: case OpCode::DIV: case OpCode::MOD: return 6;
+            case OpCode::POW: return 7;
+            default: return 8;  // !, ++, --, unary minus
+        }
+    }
+
+    /**
+     * Checks if an operator is right-associative.
+     * Right-associative operators are evaluated from right to left (e.g., exponentiation).
+     */
+    static bool isRightAssociative(OpCode op) {
+        return op == OpCode::POW || isUnaryOperator(op);
+    }
+
+    /**
+     * Determines if an operator is unary.
+     * Unary operators operate on a single operand (e.g., -3 or !1).
+     */
+    static bool isUnaryOperator(OpCode op) {
+        return op >= OpCode::NOT && op <= OpCode::NEG;
+    }
+
+    /**
+     * Checks if a token is a binary operator.
+     */
+    static bool isBinaryOperator(const Token& token) {
+        return token.kind == Token::Kind::Operator && !isUnaryOperator(token.op);
+    }
+
+    /**
+     * Checks if a token is a number or a variable.
+     */
+    static bool isOperand(const Token& token) {
+        return token.kind == Token::Kind::Number || token.kind == Token::Kind::Real || token.kind == Token::Kind::Variable;
+    }
+
+    /**
+     * Checks if a token is a unary operator.
+     */
+    static bool isUnaryOperator(const Token& token) {
+        return token.kind == Token::Kind::Operator && isUnaryOperator(token.op);
+    }
+
+    /**
+     * Decodes the digit run at the start of text. Stores its length and value and returns true,
+     * or returns false if the value does not fit in an int64_t.
+     *
+     * Groups of eight digits are validated and converted together with SWAR arithmetic on a
+     * single 64-bit word (assuming little-endian byte order), and the rest one digit at a time.
+     */
+    static bool parseDigits(string_view text, size_t& length, int64_t& value) {
+        const char* digits = text.data();
+        size_t i = 0;
+        uint64_t result = 0;
+
+        while (i + 8 <= text.size()) {
+            uint64_t chunk;
+            memcpy(&chunk, digits + i, sizeof(chunk));
+            // Every byte must be 0x30..0x39: high nibble 3, and still 3 after adding 6.
+            if (((chunk & 0xF0F0F0F0F0F0F0F0) | (((chunk + 0x0606060606060606) & 0xF0F0F0F0F0F0F0F0) >> 4)) != 0x3333333333333333)
+                break;
+            chunk = (chunk & 0x0F0F0F0F0F0F0F0F) * 2561 >> 8;           // pairs of digits
+            chunk = (chunk & 0x00FF00FF00FF00FF) * 6553601 >> 16;       // groups of four
+            result = result * 100000000 + ((chunk & 0x0000FFFF0000FFFF) * 42949672960001 >> 32);
+            i += 8;
+        }
+        while (i < text.size() && isDigit(digits[i]))
+            result = result * 10 + (digits[i++] - '0');
+
+        // Up to 19 significant digits cannot wrap a uint64_t, so checking the count and then
+        // the value detects every overflow.
+        size_t zeros = 0;
+        while (zeros < i && digits[zeros] == '0') ++zeros;
+        if (i - zeros > 19 || result > static_cast<uint64_t>(INT64_MAX)) return false;
+
+        length = i;
+        value = static_cast<int64_t>(result);
+        return true;
+    }
+
+    /**
+     * Checks whether a decimal literal that from_chars() reported out of range is too small for a
+     * double rather than too large, from the power of ten of its first significant digit.
+     */
+    static bool underflows(string_view literal) {
+        size_t exponentStart = min(literal.find_first_of("eE"), literal.size());
+        string_view mantissa = literal.substr(0, exponentStart);
+        size_t point = min(mantissa.find('.'), mantissa.size());
+        size_t first = mantissa.find_first_not_of("0.");
+        if (first == string_view::npos) return true;
+        int64_t order = first < point ? static_cast<int64_t>(point - first) - 1 : -static_cast<int64_t>(first - point);
+
+        int64_t exponent = 0;
+        if (exponentStart < literal.size()) {
+            string_view digits = literal.substr(exponentStart + 1);
+            bool negative = digits.starts_with('-');
+            if (negative || digits.starts_with('+')) digits.remove_prefix(1);
+            if (from_chars(digits.data(), digits.data() + digits.size(), exponent).ec != errc())
+                exponent = INT32_MAX;  // more exponent digits than an int64_t holds
+            if (negative) exponent = -exponent;
+        }
+        return order + exponent < 0;
+    }
+
+    /**
+     * Scans the token that starts at or after position i, skipping whitespace, and leaves i just
+     * past it. Returns false if only whitespace is left. previous is the token before it, if any,
+     * which decides whether '-' is a unary minus.
+     *
+     * Variables are resolved to slot indices in variables. If fixedLayout is set the names
+     * must already be listed there; otherwise new names are appended in order of appearance.
+     */
+    static bool scanToken(string_view expr, size_t& i, const Token* previous, VariableLayout& variables, bool fixedLayout,
+                          Token& token) {
+        auto classOf = [](char c) { return charClasses[static_cast<unsigned char>(c)]; };
+
+        // Skip whitespace
+        i = skipSpaces(expr, i);
+        if (i == expr.length()) return false;
+
+        char c = expr[i];
+        CharClass kind = classOf(c);
+        uint32_t offset = static_cast<uint32_t>(i);
+
+        // Parse numbers, decoding them once here so evaluation never re-reads the text
+        if (kind == CharClass::Digit || (kind == CharClass::Dot && i + 1 < expr.length() && classOf(expr[i + 1]) == CharClass::Digit)) {
+            size_t length = 0;
+            int64_t value = 0;
+            bool fits = parseDigits(expr.substr(i), length, value);
+            size_t next = i + length;
+            if (!fits || (next < expr.length() && (expr[next] == '.' || expr[next] == 'e' || expr[next] == 'E'))) {
+                // A fraction or exponent, or an integer too long for parseDigits: let from_chars
+                // decide, which rounds correctly. "2e" stays the integer 2 followed by a name.
+                // Integers too long for an int64_t become Real too, so double programs can use
+                // them; integer programs report them as out of range when emitting bytecode.
+                double real;
+                auto [end, error] = from_chars(expr.data() + i, expr.data() + expr.length(), real);
+                if (error == errc::result_out_of_range) {
+                    if (!underflows(expr.substr(i, end - (expr.data() + i))))
+                        throw ExpressionError("Number out of range @ char: " + to_string(offset), ErrorCode::Range);
+                    real = 0;  // too small for a double, as for IEEE arithmetic
+                }
+                bool integral = all_of(expr.data() + i, end, isDigit);
+                if (!fits || !integral) {
+                    token = {Token::Kind::Real, OpCode::ADD, offset, bit_cast<int64_t>(real)};
+                    i = end - expr.data();
+                    return true;
+                }
+            }
+            token = {Token::Kind::Number, OpCode::ADD, offset, value};
+            i = next;
+        }
+        // Parse variable names (letters, digits, and underscores, not starting with a digit)
+        else if (kind == CharClass::Letter) {
+            size_t start = i;
+            i = skipNameCharacters(expr, i + 1);
+            string_view name = expr.substr(start, i - start);
+
+            size_t slot = variables.find(name);
+            if (slot == variables.names.size()) {
+                if (fixedLayout)
+                    throw ExpressionError("Unknown variable: " + string(name) + " @ char: " + to_string(offset),
+                                          ErrorCode::UnknownVariable);
+                slot = variables.add(name);
+            }
+            token = {Token::Kind::Variable, OpCode::ADD, offset, static_cast<int64_t>(slot)};
+        }
+        else if (kind == CharClass::LeftParen) {
+            token = {Token::Kind::LeftParen, OpCode::ADD, offset, 0};
+            ++i;
+        }
+        else if (kind == CharClass::RightParen) {
+            token = {Token::Kind::RightParen, OpCode::ADD, offset, 0};
+            ++i;
+        }
+        // Handle operators
+        else {
+            // Try to form a two-character operator (e.g., >=, <=, ==, ++, etc.)
+            if ((kind == CharClass::Operator || kind == CharClass::OperatorPart) && i + 1 < expr.length()) {
+                const TwoCharOperator& twoChar = twoCharOperators[twoCharHash(c, expr[i + 1])];
+                if (twoChar.first == c && twoChar.second == expr[i + 1]) {
+                    token = {Token::Kind::Operator, twoChar.op, offset, 0};
+                    i += 2;
+                    return true;
+                }
+            }
+
+            if (kind != CharClass::Operator)
+                throw ExpressionError("Unknown operator: " + string(1, c) + " @ char: " + to_string(offset));
+
+            // If '-' is at the beginning or after a left parenthesis or another operator,
+            // treat it as unary negative (e.g., -3 becomes "neg 3")
+            OpCode op = singleCharOperators[static_cast<unsigned char>(c)];
+            if (op == OpCode::SUB && (!previous || previous->kind == Token::Kind::LeftParen ||
+                                      previous->kind == Token::Kind::Operator))
+                op = OpCode::NEG;
+            token = {Token::Kind::Operator, op, offset, 0};
+            ++i;
+        }
+        return true;
+    }
+
+    /**
+     * Tokenizes an input string into a vector of valid expression elements (tokens),
+     * including numbers, variables, operators, and parentheses. Also handles implicit unary minus.
+     *
+     * Tokens refer to the source by offset and carry decoded values, and names are views into
+     * expr, so tokenizing into reused buffers does not allocate.
+     */
+    static void tokenizeExpression(string_view expr, VariableLayout& variables, bool fixedLayout, vector<Token>& tokens) {
+        tokens.clear();
+        Token token;
+        for (size_t i = 0; scanToken(expr, i, tokens.empty() ? nullptr : &tokens.back(), variables, fixedLayout, token); )
+            tokens.push_back(token);
+    }
+
+    /**
+     * Performs error checking on the list of tokens to identify malformed expressions.
+     * Checks for issues like consecutive operators, misplaced parentheses, and division by zero.
+     */
+    static void validateTokenSequence(const vector<Token>& tokens) {
+        for (size_t i = 0; i < tokens.size(); ++i) {
+            const Token& token = tokens[i];
+            const Token* prev = (i > 0) ? &tokens[i - 1] : nullptr;
+            const Token* next = (i + 1 < tokens.size()) ? &tokens[i + 1] : nullptr;
+
+            // Can't start with a closing parenthesis
+            if (token.kind == Token::Kind::RightParen && i == 0)
+                throw ExpressionError("Expression can't start with a closing parenthesis @ char: " + to_string(token.offset));
+
+            // Can't start with a binary operator
+            if (isBinaryOperator(token) && i == 0)
+                throw ExpressionError("Expression can't start with a binary operator @ char: " + to_string(token.offset));
+
+            // Two binary operators in a row (e.g., "3 && && 4")
+            if (isBinaryOperator(token) && prev && isBinaryOperator(*prev))
+                throw ExpressionError("Two binary operators in a row @ char: " + to_string(token.offset));
+
+            // Two operands in a row (e.g., "4 5" or "x 5")
+            if (isOperand(token) && prev && isOperand(*prev))
+                throw ExpressionError("Two operands in a row @ char: " + to_string(token.offset));
+
+            // A unary operator directly followed by a binary operator (e.g., ++ < 5)
+            if (isUnaryOperator(token) && next && isBinaryOperator(*next))
+                throw ExpressionError("A unary operand can’t be followed by a binary operator @ char: " + to_string(next->offset));
+        }
+    }
+
+    /**
+     * Converts infix tokens to postfix (Reverse Polish Notation) using the Shunting Yard Algorithm.
+     */
+    static void convertToPostfix(const vector<Token>& tokens, vector<Token>& output, vector<Token>& operators) {
+        output.clear();
+        operators.clear();
+
+        for (const Token& token : tokens) {
+            if (isOperand(token)) {
+                output.push_back(token);
+            } else if (token.kind == Token::Kind::LeftParen) {
+                operators.push_back(token);
+            } else if (token.kind == Token::Kind::RightParen) {
+                while (!operators.empty() && operators.back().kind != Token::Kind::LeftParen) {
+                    output.push_back(operators.back());
+                    operators.pop_back();
+                }
+                if (!operators.empty()) operators.pop_back(); // Remove the '('
+            } else {
+                int precedence = operatorPrecedence(token.op);
+                while (!operators.empty() && operators.back().kind != Token::Kind::LeftParen &&
+                       ((isRightAssociative(token.op) && precedence < operatorPrecedence(operators.back().op)) ||
+                        (!isRightAssociative(token.op) && precedence <= operatorPrecedence(operators.back().op)))) {
+                    output.push_back(operators.back());
+                    operators.pop_back();
+                }
+                operators.push_back(token);
+            }
+        }
+
+        // Pop remaining operators
+        while (!operators.empty()) {
+            if (operators.back().kind == Token::Kind::LeftParen)
+                throw ExpressionError("Missing closing parenthesis @ char: " + to_string(operators.back().offset));
+            output.push_back(operators.back());
+            operators.pop_back();
+        }
+    }
+
+    /**
+     * How deep the Pratt parser may recurse: each parenthesis, prefix operator and operand of a
+     * tighter-binding operator is one level. Deeper expressions are left to convertToPostfix(),
+     * which keeps its stack on the heap.
+     */
+    static constexpr uint32_t maxParseDepth = 256;
+
+    /**
+     * The state of parseToPostfix(): the source, the position after the lookahead token, and the
+     * lookahead itself. Tokens are scanned one at a time as the parser consumes them.
+     */
+    struct PrattParser {
+        string_view expr;
+        VariableLayout& variables;
+        bool fixedLayout;
+        vector<Token>& output;
+        size_t position = 0;
+        Token lookahead{};
+        bool atEnd = false;
+
+        /**
+         * Consumes the lookahead and scans the token after it.
+         */
+        void advance() {
+            Token consumed = lookahead;
+            atEnd = !scanToken(expr, position, &consumed, variables, fixedLayout, lookahead);
+        }
+    };
+
+    /**
+     * Parses an operand: a number, a variable, a parenthesized expression, or a prefix operator
+     * applied to an operand. A number, variable or parenthesized expression may be followed by
+     * unary operators, which apply to it last to first, as convertToPostfix() stacks them.
+     */
+    static bool parseOperand(PrattParser& parser, uint32_t depth) {
+        if (parser.atEnd || depth > maxParseDepth) return false;
+        Token token = parser.lookahead;
+        if (isOperand(token)) {
+            parser.output.push_back(token);
+            parser.advance();
+        } else if (token.kind == Token::Kind::LeftParen) {
+            parser.advance();
+            if (!parseBinary(parser, 0, depth + 1) || parser.atEnd || parser.lookahead.kind != Token::Kind::RightParen)
+                return false;
+            parser.advance();
+        } else if (isUnaryOperator(token)) {
+            parser.advance();
+            if (!parseOperand(parser, depth + 1)) return false;
+            parser.output.push_back(token);
+            return true;
+        } else {
+            return false;
+        }
+
+        size_t first = parser.output.size();
+        while (!parser.atEnd && isUnaryOperator(parser.lookahead)) {
+            parser.output.push_back(parser.lookahead);
+            parser.advance();
+        }
+        // A unary operator can't be followed by a binary operator
+        if (parser.output.size() != first && !parser.atEnd && isBinaryOperator(parser.lookahead)) return false;
+        reverse(parser.output.begin() + first, parser.output.end());
+        return true;
+    }
+
+    /**
+     * Parses operands joined by binary operators of at least minPrecedence, writing each operator
+     * after its operands. A right-associative operator parses its right side at its own
+     * precedence, so it groups to the right; the others one level up, so they group to the left.
+     */
+    static bool parseBinary(PrattParser& parser, int minPrecedence, uint32_t depth) {
+        if (!parseOperand(parser, depth)) return false;
+        while (!parser.atEnd && isBinaryOperator(parser.lookahead)) {
+            Token token = parser.lookahead;
+            int precedence = operatorPrecedence(token.op);
+            if (precedence < minPrecedence) break;
+            parser.advance();
+            if (!parseBinary(parser, isRightAssociative(token.op) ? precedence : precedence + 1, depth + 1)) return false;
+            parser.output.push_back(token);
+        }
+        return true;
+    }
+
+    /**
+     * A one-pass alternative to tokenizeExpression(), validateTokenSequence() and
+     * convertToPostfix(): a Pratt parser that scans each token when it needs it, checks it
+     * against the grammar, and writes the syntax tree into output. The tree is stored in
+     * postfix order, the form the later passes work on: an operator's right operand is the
+     * subtree that ends just before it, and its left operand the one that ends before that.
+     * The result is the same postfix convertToPostfix() produces.
+     *
+     * Returns false, without reporting an error, for anything the parser does not accept
+     * (malformed input, stray closing parentheses, nesting deeper than maxParseDepth) so that
+     * the three passes can handle it exactly as before. Errors from scanning a token are
+     * thrown here; the tokenizer would report the same one first.
+     */
+    static bool parseToPostfix(string_view expr, VariableLayout& variables, bool fixedLayout, vector<Token>& output) {
+        output.clear();
+        PrattParser parser{expr, variables, fixedLayout, output};
+        parser.atEnd = !scanToken(expr, parser.position, nullptr, variables, fixedLayout, parser.lookahead);
+        return parseBinary(parser, 0, 0) && parser.atEnd;
+    }
+
+    /**
+     * Checks if a token is a literal that Value programs can hold, and so can be folded.
+     */
+    template <typename Value>
+    static bool isFoldableLiteral(const Token& token) {
+        using Immediate = typename BasicCompiledExpression<Value>::Immediate;
+        if (token.kind == Token::Kind::Real) return is_floating_point_v<Value>;
+        return token.kind == Token::Kind::Number && token.value <= numeric_limits<Immediate>::max();
+    }
+
+    /**
+     * Checks if a literal token equals an integer.
+     */
+    static bool literalEquals(const Token& token, int64_t value) {
+        return token.kind == Token::Kind::Real ? bit_cast<double>(token.value) == static_cast<double>(value)
+                                               : token.value == value;
+    }
+
+    /**
+     * Applies op to count literal operands by running it through the interpreter under policy,
+     * so the folded value is exactly what run() would compute. Stores the literal for the result
+     * and returns true, or returns false if the operation would fail at run time (so the error is
+     * still reported there, with its position) or the result cannot be written as a literal.
+     */
+    template <typename Value>
+    static bool foldOperation(OpCode op, const Token* operands, int count, OverflowPolicy policy, Token& result) {
+        using Program = BasicCompiledExpression<Value>;
+        using Immediate = typename Program::Immediate;
+        if constexpr (!isFixedWidth<Value>) return false;  // see foldConstants()
+
+        uint8_t code[2 * (1 + sizeof(Immediate)) + 1 + sizeof(uint32_t)] = {};
+        size_t size = 0;
+        for (int i = 0; i < count; ++i) {
+            Immediate immediate = operands[i].kind == Token::Kind::Real ? static_cast<Immediate>(bit_cast<double>(operands[i].value))
+                                                                       : static_cast<Immediate>(operands[i].value);
+            code[size++] = static_cast<uint8_t>(OpCode::PUSH);
+            memcpy(code + size, &immediate, sizeof(immediate));
+            size += sizeof(immediate);
+        }
+        code[size++] = static_cast<uint8_t>(op);
+        if (isArithmetic(op)) size += sizeof(uint32_t);  // the source offset, never reported here
+
+        Value values[2];
+        Value value;
+        try {
+            value = Program::execute(policy, code, code + size, values, nullptr);
+        } catch (const ExpressionError&) {
+            return false;
+        }
+
+        uint32_t offset = operands[0].offset;
+        if constexpr (is_floating_point_v<Value>) {
+            result = {Token::Kind::Real, OpCode::ADD, offset, bit_cast<int64_t>(value)};
+        } else if constexpr (isFixedWidth<Value>) {
+            if constexpr (sizeof(Value) > sizeof(int64_t)) {
+                if (value < INT64_MIN || value > INT64_MAX) return false;
+            }
+            result = {Token::Kind::Number, OpCode::ADD, offset, static_cast<int64_t>(value)};
+        }
+        return true;
+    }
+
+    /**
+     * Simplifies a postfix program in place. Operators whose operands are all literals are folded,
+     * and identities are applied where they cannot change a result or hide an error: x * 1, x + 0,
+     * x - 0 and x / 1 become x, !!b becomes b, and 1 && b or 0 || b become b when b is known to be
+     * 0 or 1. x * 0, 0 && y and 1 || y become constants only when the dropped side cannot fail.
+     * x + 0 and x * 0 are kept for floating-point programs, where they are not identities for
+     * -0.0, infinities and NaN. BigInt literals are not folded, as their results may not fit a token.
+     *
+     * A malformed program is left as it is from the first operator that lacks operands, so
+     * emitBytecode() reports the same error it would have without folding.
+     */
+    template <typename Value>
+    static void foldConstants(vector<Token>& postfix, OverflowPolicy policy, vector<FoldNode>& nodes) {
+        constexpr bool floating = is_floating_point_v<Value>;
+        nodes.clear();
+        size_t size = 0;  // postfix[0, size) holds the simplified program so far
+
+        auto literalNode = [](uint32_t start, const Token& token) {
+            return FoldNode{start, true, literalEquals(token, 0) || literalEquals(token, 1), false, false};
+        };
+
+        for (size_t i = 0; i < postfix.size(); ++i) {
+            Token token = postfix[i];
+            uint32_t start = static_cast<uint32_t>(size);
+
+            if (token.kind != Token::Kind::Operator) {
+                postfix[size++] = token;
+                // A literal the program cannot hold must survive to emitBytecode(), which rejects it.
+                bool rejected = token.kind != Token::Kind::Variable;
+                nodes.push_back(isFoldableLiteral<Value>(token) ? literalNode(start, token) : FoldNode{start, false, false, rejected, false});
+                continue;
+            }
+
+            OpCode op = token.op;
+            bool unary = isUnaryOperator(op);
+            if (nodes.size() < (unary ? 1u : 2u)) {
+                size = copy(postfix.begin() + i, postfix.end(), postfix.begin() + size) - postfix.begin();
+                break;
+            }
+
+            if (unary) {
+                FoldNode& operand = nodes.back();
+                if (operand.literal && foldOperation<Value>(op, &postfix[size - 1], 1, policy, postfix[size - 1])) {
+                    operand = literalNode(operand.start, postfix[size - 1]);
+                } else if (op == OpCode::NOT && operand.negation) {
+                    --size;  // !!b is b
+                    operand.negation = false;
+                } else {
+                    postfix[size++] = token;
+                    operand = {operand.start, false, op == OpCode::NOT, operand.canFail || BasicCompiledExpression<Value>::canFail(op, policy),
+                               op == OpCode::NOT && operand.boolean};
+                }
+                continue;
+            }
+
+            FoldNode right = nodes.back();
+            nodes.pop_back();
+            FoldNode& left = nodes.back();
+            if (left.literal && right.literal) {
+                Token folded;
+                if (foldOperation<Value>(op, &postfix[size - 2], 2, policy, folded)) {
+                    postfix[left.start] = folded;
+                    size = left.start + 1;
+                    left = literalNode(left.start, folded);
+                    continue;
+                }
+            }
+
+            auto is = [&postfix](const FoldNode& node, int64_t value) { return node.literal && literalEquals(postfix[node.start], value); };
+            auto isNonzero = [&postfix](const FoldNode& node) { return node.literal && !literalEquals(postfix[node.start], 0); };
+            auto keepLeft = [&] { size = right.start; };
+            auto keepRight = [&] {
+                size = copy(postfix.begin() + right.start, postfix.begin() + size, postfix.begin() + left.start) - postfix.begin();
+                right.start = left.start;
+                left = right;
+            };
+            auto replaceWith = [&](int64_t value) {
+                postfix[left.start] = {Token::Kind::Number, OpCode::ADD, postfix[left.start].offset, value};
+                size = left.start + 1;
+                left = literalNode(left.start, postfix[left.start]);
+            };
+
+            if ((op == OpCode::ADD && !floating && is(right, 0)) || (op == OpCode::SUB && is(right, 0)) ||
+                ((op == OpCode::MUL || op == OpCode::DIV) && is(right, 1)) ||
+                (op == OpCode::AND && isNonzero(right) && left.boolean) || (op == OpCode::OR && is(right, 0) && left.boolean)) {
+                keepLeft();
+            } else if ((op == OpCode::ADD && !floating && is(left, 0)) || (op == OpCode::MUL && is(left, 1)) ||
+                       (op == OpCode::AND && isNonzero(left) && right.boolean) || (op == OpCode::OR && is(left, 0) && right.boolean)) {
+                keepRight();
+            } else if ((op == OpCode::MUL && !floating && ((is(left, 0) && !right.canFail) || (is(right, 0) && !left.canFail))) ||
+                       (op == OpCode::AND && ((is(left, 0) && !right.canFail) || (is(right, 0) && !left.canFail)))) {
+                replaceWith(0);
+            } else if ((op == OpCode::OR && ((isNonzero(left) && !right.canFail) || (isNonzero(right) && !left.canFail))) ||
+                       (op == OpCode::POW && is(right, 0) && !left.canFail)) {
+                replaceWith(1);
+            } else {
+                postfix[size++] = token;
+                bool boolean = (op >= OpCode::EQ && op <= OpCode::LE) || op == OpCode::AND || op == OpCode::OR;
+                left = {left.start, false, boolean, left.canFail || right.canFail || BasicCompiledExpression<Value>::canFail(op, policy), false};
+            }
+        }
+
+        postfix.resize(size);
+    }
+
+    /**
+     * Common subexpression elimination. Hash-conses the postfix program into a DAG of distinct
+     * subtrees; an operator subtree of at least three tokens that occurs more than once is then
+     * copied into a temporary (STORE) where it is computed, and later occurrences push the copy
+     * (FETCH) instead of recomputing it. The program is prefixed with a RESERVE of the temporaries.
+     *
+     * The right side of && and || may be skipped, so a copy is only fetched where the computation
+     * that stored it is certain to have run: earlier outside any right side, or earlier within the
+     * same right side. Anywhere else the subtree is computed and stored again. Evaluation stays
+     * left to right, so a shared subtree fails, if at all, exactly where it did before.
+     *
+     * Leaves postfix unchanged if nothing is shared or the program is malformed, which
+     * emitBytecode() then reports.
+     */
+    static void eliminateCommonSubexpressions(vector<Token>& postfix, CompileScratch& scratch) {
+        constexpr uint32_t none = UINT32_MAX;
+        vector<DagNode>& nodes = scratch.nodes;
+        vector<uint32_t>& table = scratch.nodeTable;
+        vector<uint32_t>& tokenNodes = scratch.tokenNodes;
+        vector<uint32_t>& tokenStarts = scratch.tokenStarts;
+        vector<uint32_t>& regions = scratch.regions;  // each token's parent, then its innermost right side
+        vector<uint32_t>& stack = scratch.operandStack;
+        size_t count = postfix.size();
+
+        size_t capacity = 16;
+        while (capacity < 2 * count) capacity *= 2;
+        table.assign(capacity, 0);
+        nodes.clear();
+        tokenNodes.resize(count);
+        tokenStarts.resize(count);
+        regions.assign(count, none);
+        stack.clear();
+
+        bool shared = false;
+        for (size_t i = 0; i < count; ++i) {
+            const Token& token = postfix[i];
+            uint32_t left = none, right = none, start = static_cast<uint32_t>(i);
+            if (token.kind == Token::Kind::Operator) {
+                size_t operands = isUnaryOperator(token.op) ? 1 : 2;
+                if (stack.size() < operands) return;
+                if (operands == 2) {
+                    right = tokenNodes[stack.back()];
+                    regions[stack.back()] = static_cast<uint32_t>(i);
+                    stack.pop_back();
+                }
+                left = tokenNodes[stack.back()];
+                start = tokenStarts[stack.back()];
+                regions[stack.back()] = static_cast<uint32_t>(i);
+                stack.pop_back();
+            }
+
+            // Operands are keyed by value or slot, operators by their children; offsets are ignored.
+            int64_t value = token.kind == Token::Kind::Operator ? 0 : token.value;
+            uint64_t hash = (static_cast<uint64_t>(token.kind) << 8 | static_cast<uint64_t>(token.op)) ^ static_cast<uint64_t>(value);
+            hash = (hash * 0x9E3779B97F4A7C15 ^ left) * 0x9E3779B97F4A7C15 ^ right;
+            hash = (hash ^ hash >> 29) * 0xBF58476D1CE4E5B9;
+            size_t bucket = (hash ^ hash >> 32) & (capacity - 1);
+            while (table[bucket] != 0) {
+                const DagNode& node = nodes[table[bucket] - 1];
+                if (node.kind == token.kind && node.op == token.op && node.value == value && node.left == left && node.right == right)
+                    break;
+                bucket = (bucket + 1) & (capacity - 1);
+            }
+            if (table[bucket] == 0) {
+                nodes.push_back({token.kind, token.op, value, left, right, 0, none, none});
+                table[bucket] = static_cast<uint32_t>(nodes.size());
+                if (left != none) ++nodes[left].refs;
+                if (right != none) ++nodes[right].refs;
+            } else {
+                shared |= token.kind == Token::Kind::Operator;
+            }
+            tokenNodes[i] = table[bucket] - 1;
+            tokenStarts[i] = start;
+            stack.push_back(static_cast<uint32_t>(i));
+        }
+        if (!shared) return;
+
+        // Parents come after their children, so a backward pass turns parents into right sides,
+        // each named by the index of its && or || token.
+        for (size_t i = count; i-- > 0; ) {
+            uint32_t parent = regions[i];
+            if (parent == none) continue;
+            bool rightSide = (postfix[parent].op == OpCode::AND || postfix[parent].op == OpCode::OR) && parent == i + 1;
+            regions[i] = rightSide ? parent : regions[parent];
+        }
+
+        // Occurrences worth sharing, chained from the outermost one starting at each token inward.
+        vector<uint32_t>& outermost = scratch.outermost;
+        vector<uint32_t>& enclosed = scratch.enclosed;
+        vector<uint32_t>& fetched = scratch.fetched;  // whether the computation ending at a token is fetched
+        outermost.assign(count, none);
+        enclosed.resize(count);
+        fetched.assign(count, 0);
+        auto isShareable = [&](size_t i) {
+            const DagNode& node = nodes[tokenNodes[i]];
+            return node.kind == Token::Kind::Operator && node.refs >= 2 && i - tokenStarts[i] >= 2;
+        };
+        for (size_t i = 0; i < count; ++i) {
+            if (!isShareable(i)) continue;
+            enclosed[i] = outermost[tokenStarts[i]];
+            outermost[tokenStarts[i]] = static_cast<uint32_t>(i);
+        }
+        auto isCopied = [&](uint32_t occurrence) {
+            uint32_t stored = nodes[tokenNodes[occurrence]].store;
+            if (stored == none) return false;
+            uint32_t region = regions[stored];
+            return region == none || (tokenStarts[region - 1] <= tokenStarts[occurrence] && occurrence < region);
+        };
+
+        // Each STORE carries the index of the computation it copies until the unfetched ones are dropped.
+        vector<Token>& output = scratch.shared;
+        output.clear();
+        output.push_back({Token::Kind::Operator, OpCode::RESERVE, 0, 0});
+        uint32_t temps = 0;
+        for (size_t i = 0; i < count; ++i) {
+            uint32_t occurrence = outermost[i];
+            while (occurrence != none && !isCopied(occurrence)) occurrence = enclosed[occurrence];
+            if (occurrence != none) {
+                DagNode& node = nodes[tokenNodes[occurrence]];
+                if (node.temp == none) node.temp = temps++;
+                fetched[node.store] = 1;
+                output.push_back({Token::Kind::Operator, OpCode::FETCH, postfix[occurrence].offset, node.temp});
+                i = occurrence;
+                continue;
+            }
+            output.push_back(postfix[i]);
+            if (isShareable(i)) {
+                nodes[tokenNodes[i]].store = static_cast<uint32_t>(i);
+                output.push_back({Token::Kind::Operator, OpCode::STORE, postfix[i].offset, static_cast<int64_t>(i)});
+            }
+        }
+        if (temps == 0) return;
+
+        size_t size = 0;
+        for (Token token : output) {
+            if (token.kind == Token::Kind::Operator && token.op == OpCode::STORE) {
+                uint32_t computed = static_cast<uint32_t>(token.value);
+                if (!fetched[computed]) continue;
+                token.value = nodes[tokenNodes[computed]].temp;
+            }
+            output[size++] = token;
+        }
+        output.resize(size);
+        output[0].value = temps;
+        postfix.assign(output.begin(), output.end());
+    }
+
+    /**
+     * Inserts the jumps that let && and || skip their right side when the left side decides the
+     * result, which is what keeps 0 && 1 / 0 from reporting an error. The && or || token that ends
+     * a right side is marked with value 1. Leaves a malformed program unchanged for emitBytecode()
+     * to report.
+     */
+    static void insertShortCircuitJumps(vector<Token>& postfix, CompileScratch& scratch) {
+        constexpr uint32_t none = UINT32_MAX;
+        vector<uint32_t>& tokenStarts = scratch.tokenStarts;
+        vector<uint32_t>& rightSides = scratch.rightSides;
+        vector<uint32_t>& stack = scratch.operandStack;
+        size_t count = postfix.size();
+
+        tokenStarts.resize(count);
+        rightSides.assign(count, none);
+        stack.clear();
+
+        bool jumps = false;
+        for (size_t i = 0; i < count; ++i) {
+            const Token& token = postfix[i];
+            bool isOperator = token.kind == Token::Kind::Operator;
+            if (isOperator && token.op == OpCode::RESERVE) continue;
+
+            uint32_t start = static_cast<uint32_t>(i);
+            if (isOperator && token.op != OpCode::FETCH) {
+                size_t operands = isUnaryOperator(token.op) || token.op == OpCode::STORE ? 1 : 2;
+                if (stack.size() < operands) return;
+                if (operands == 2) {
+                    if (token.op == OpCode::AND || token.op == OpCode::OR) {
+                        rightSides[tokenStarts[stack.back()]] = static_cast<uint32_t>(i);
+                        jumps = true;
+                    }
+                    stack.pop_back();
+                }
+                start = tokenStarts[stack.back()];
+                stack.pop_back();
+            }
+            tokenStarts[i] = start;
+            stack.push_back(static_cast<uint32_t>(i));
+        }
+        if (!jumps) return;
+
+        // Right sides are nested or disjoint, so at most one starts at any token.
+        vector<Token>& output = scratch.shared;
+        output.clear();
+        for (size_t i = 0; i < count; ++i) {
+            uint32_t end = rightSides[i];
+            if (end != none) {
+                OpCode jump = postfix[end].op == OpCode::AND ? OpCode::JUMP_IF_ZERO : OpCode::JUMP_IF_NONZERO;
+                output.push_back({Token::Kind::Operator, jump, postfix[end].offset, 0});
+                postfix[end].value = 1;
+            }
+            output.push_back(postfix[i]);
+        }
+        postfix.assign(output.begin(), output.end());
+    }
+
+    /**
+     * Packs a postfix token sequence into bytecode for Value programs and returns the frame size:
+     * the temporaries plus the maximum stack depth. Simulates the value stack while doing so, so
+     * operand-count errors are reported here and the interpreter can skip those checks.
+     */
+    template <typename Value>
+    static uint32_t emitBytecode(const vector<Token>& postfix, vector<uint8_t>& code) {
+        using Immediate = typename BasicCompiledExpression<Value>::Immediate;
+        code.clear();
+        uint32_t depth = 0, maxDepth = 0, temps = 0;
+        size_t lastPush = SIZE_MAX;  // offset of the previous instruction if it was a PUSH
+        uint32_t openJump = UINT32_MAX;  // distance field of the innermost unpatched jump, which holds the next one's
+
+        auto emit = [&code](OpCode op) { code.push_back(static_cast<uint8_t>(op)); };
+        auto emitImmediate = [&code](auto immediate) {
+            const uint8_t* raw = reinterpret_cast<const uint8_t*>(&immediate);
+            code.insert(code.end(), raw, raw + sizeof(immediate));
+        };
+
+        for (const Token& token : postfix) {
+            if (token.kind == Token::Kind::Number || token.kind == Token::Kind::Real) {
+                Immediate immediate;
+                if (token.kind == Token::Kind::Number) {
+                    if (token.value > numeric_limits<Immediate>::max())
+                        throw ExpressionError("Number out of range @ char: " + to_string(token.offset), ErrorCode::Range);
+                    immediate = static_cast<Immediate>(token.value);
+                } else if constexpr (is_floating_point_v<Value>) {
+                    immediate = bit_cast<double>(token.value);
+                } else {
+                    // Whole numbers beyond int64_t, such as 12345678901234567890 or 1e19, do not fit.
+                    double real = bit_cast<double>(token.value);
+                    if (real == trunc(real) && fabs(real) >= 0x1p63)
+                        throw ExpressionError("Number out of range @ char: " + to_string(token.offset), ErrorCode::Range);
+                    throw ExpressionError("Decimal number in an integer expression @ char: " + to_string(token.offset),
+                                          ErrorCode::Range);
+                }
+                lastPush = code.size();
+                emit(OpCode::PUSH);
+                emitImmediate(immediate);
+                maxDepth = max(maxDepth, ++depth);
+                continue;
+            }
+            if (token.kind == Token::Kind::Variable) {
+                emit(OpCode::LOAD);
+                emitImmediate(static_cast<int32_t>(token.value));
+                maxDepth = max(maxDepth, ++depth);
+                lastPush = SIZE_MAX;
+                continue;
+            }
+            if (token.op == OpCode::RESERVE || token.op == OpCode::STORE || token.op == OpCode::FETCH) {
+                emit(token.op);
+                emitImmediate(static_cast<uint32_t>(token.value));
+                if (token.op == OpCode::RESERVE) temps = static_cast<uint32_t>(token.value);
+                if (token.op == OpCode::FETCH) maxDepth = max(maxDepth, ++depth);
+                lastPush = SIZE_MAX;
+                continue;
+            }
+            if (token.op == OpCode::JUMP_IF_ZERO || token.op == OpCode::JUMP_IF_NONZERO) {
+                emit(token.op);
+                emitImmediate(openJump);
+                openJump = static_cast<uint32_t>(code.size() - sizeof(openJump));
+                lastPush = SIZE_MAX;
+                continue;
+            }
+
+            if (isUnaryOperator(token.op)) {
+                if (depth < 1) throw ExpressionError("Missing operand for unary operator");
+                emit(token.op);
+                if (isArithmetic(token.op)) emitImmediate(token.offset);
+            } else {
+                if (depth < 2) throw ExpressionError("Missing operands for binary operator");
+                --depth;
+                Immediate exponent = 0;
+                if (token.op == OpCode::POW && lastPush != SIZE_MAX)
+                    memcpy(&exponent, &code[lastPush + 1], sizeof(exponent));
+                if (token.op == OpCode::POW && lastPush != SIZE_MAX && exponent >= 0 && exponent <= INT32_MAX &&
+                    exponent == static_cast<int32_t>(exponent)) {
+                    // Constant exponent: drop its PUSH and specialize, x^1 to nothing and x^2 to a multiply.
+                    // Negative exponents (from folding) keep the generic POW, which checks for 0 ^ -k.
+                    code.resize(lastPush);
+                    if (exponent == 2) {
+                        emit(OpCode::SQUARE);
+                        emitImmediate(token.offset);
+                    } else if (exponent != 1) {
+                        emit(OpCode::POWI);
+                        emitImmediate(static_cast<int32_t>(exponent));
+                        emitImmediate(token.offset);
+                    }
+                } else {
+                    emit(token.op);
+                    if (isArithmetic(token.op)) emitImmediate(token.offset);
+                }
+                if ((token.op == OpCode::AND || token.op == OpCode::OR) && token.value != 0) {
+                    // The right side ends here: point its jump past this instruction.
+                    uint32_t next, distance = static_cast<uint32_t>(code.size() - (openJump + sizeof(distance)));
+                    memcpy(&next, &code[openJump], sizeof(next));
+                    memcpy(&code[openJump], &distance, sizeof(distance));
+                    openJump = next;
+                }
+            }
+            lastPush = SIZE_MAX;
+        }
+
+        if (depth != 1) throw ExpressionError("Expression evaluation error: leftover operands");
+        return temps + maxDepth;
+    }
+
+    /**
+     * Runs the whole front end into scratch, leaving the bytecode in scratch.code and the
+     * variable layout in scratch.variables. Returns the program's frame size.
+     */
+    template <typename Value>
+    static uint32_t compileInto(string_view expression, bool fixedLayout, OverflowPolicy policy, CompileScratch& scratch) {
+        size_t layout = scratch.variables.names.size();
+        if (!parseToPostfix(expression, scratch.variables, fixedLayout, scratch.postfix)) {
+            // Let the three passes report the error, or accept what they always have.
+            scratch.variables.truncate(layout);
+            tokenizeExpression(expression, scratch.variables, fixedLayout, scratch.tokens);
+            validateTokenSequence(scratch.tokens);
+            convertToPostfix(scratch.tokens, scratch.postfix, scratch.operators);
+        }
+        foldConstants<Value>(scratch.postfix, policy, scratch.foldNodes);
+        eliminateCommonSubexpressions(scratch.postfix, scratch);
+        insertShortCircuitJumps(scratch.postfix, scratch);
+        return emitBytecode<Value>(scratch.postfix, scratch.code);
+    }
+
+    /**
+     * The calling thread's compile buffers. They are the arena for all per-expression parse
+     * data: each pass clears its buffers before use, which is the O(1) reset, and they keep
+     * their capacity, so a thread stops allocating for parsing once they have grown to fit.
+     */
+    static CompileScratch& threadScratch() {
+        thread_local CompileScratch scratch;
+        return scratch;
+    }
+
+    template <typename Value>
+    BasicCompiledExpression<Value> compile(const string& expression, const vector<string>& variables, bool fixedLayout,
+                                           bool filterable = true) const {
+        CompileScratch& scratch = threadScratch();
+        scratch.variables.assign(variables.begin(), variables.end());
+        uint32_t maxDepth = compileInto<Value>(expression, fixedLayout, overflowPolicy, scratch);
+        // Copy the bytecode out so the buffer stays in the arena.
+        BasicCompiledExpression<Value> compiled(vector<uint8_t>(scratch.code.begin(), scratch.code.end()), maxDepth);
+        compiled.variableNames.assign(scratch.variables.names.begin(), scratch.variables.names.end());
+        compiled.jitThreshold = jitThreshold;
+        compiled.overflowPolicy = overflowPolicy;
+        if constexpr (isFixedWidth<Value>) {
+            using ProgramTree = typename BasicCompiledExpression<Value>::ProgramTree;
+            if (filterable) compiled.filterTree = make_shared<const ProgramTree>(compiled.buildProgramTree());
+        }
+        return compiled;
+    }
+
+    /**
+     * Compiles and runs one expression straight from scratch, without building a program.
+     */
+    static int evaluateWithScratch(string_view expression, OverflowPolicy policy, CompileScratch& scratch) {
+        scratch.variables.clear();
+        uint32_t maxDepth = compileInto<int>(expression, false, policy, scratch);
+        if (!scratch.variables.names.empty())
+            throw ExpressionError("Missing value for variable: " + string(scratch.variables.names[0]), ErrorCode::MissingValue);
+
+        const uint8_t* code = scratch.code.data();
+        if (maxDepth <= CompiledExpression::inlineStackDepth) {
+            int values[CompiledExpression::inlineStackDepth];
+            return CompiledExpression::execute(policy, code, code + scratch.code.size(), values, nullptr);
+        }
+        scratch.values.resize(maxDepth);
+        return CompiledExpression::execute(policy, code, code + scratch.code.size(), scratch.values.data(), nullptr);
+    }
+
+public:
+    /**
+     * Parses and validates an infix expression once and returns its postfix program.
+     * The result can be run any number of times without paying the parsing cost again.
+     * Value selects the width all values are computed in, e.g. compile<int64_t>(expression).
+     */
+    template <typename Value = int>
+    BasicCompiledExpression<Value> compile(const string& expression) const {
+        return compile<Value>(expression, {}, false);
+    }
+
+    /**
+     * Compiles an expression against a fixed variable layout: the value for variables[i]
+     * is passed in slot i of BasicCompiledExpression::run(). Unknown names are reported as errors.
+     */
+    template <typename Value = int>
+    BasicCompiledExpression<Value> compile(const string& expression, const vector<string>& variables) const {
+        return compile<Value>(expression, variables, true);
+    }
+
+private:
+    /**
+     * Returns the compiled program for an expression from the cache, compiling and
+     * caching it (and evicting the least recently used program if full) on a miss.
+     * Compiling happens outside the shard lock, so a slow miss never blocks other threads.
+     */
+    shared_ptr<const CompiledExpression> compileCached(const string& expression) const {
+        size_t shardIndex = hash<string_view>()(expression) % activeShards();
+        CacheShard& shard = cacheShards[shardIndex];
+        {
+            lock_guard<mutex> guard(shard.lock);
+            auto found = shard.index.find(expression);
+            if (found != shard.index.end()) {
+                ++shard.hits;
+                shard.entries.splice(shard.entries.begin(), shard.entries, found->second);
+                found->second->lastUse = cacheClock.fetch_add(1, memory_order_relaxed);
+                return found->second->program;
+            }
+            ++shard.misses;
+        }
+
+        // evaluate() only runs the program, so it is compiled without the tree filter() walks.
+        auto compiled = make_shared<const CompiledExpression>(compile<int>(expression, {}, false, false));
+        size_t capacity = shardCapacity(shardIndex);
+        if (capacity == 0) return compiled;
+
+        lock_guard<mutex> guard(shard.lock);
+        if (shard.index.count(expression)) return compiled;  // another thread cached it meanwhile
+        evict(shard, capacity - 1);
+        shard.entries.push_front({expression, compiled, cacheClock.fetch_add(1, memory_order_relaxed)});
+        shard.index.emplace(shard.entries.front().expression, shard.entries.begin());
+        return compiled;
+    }
+
+    /**
+     * Number of shards in use: all of them, or one per entry for capacities below
+     * cacheShardCount, so that every shard in use holds at least one program.
+     */
+    size_t activeShards() const {
+        return clamp<size_t>(cacheCapacity, 1, cacheShardCount);
+    }
+
+    /**
+     * The capacity is split between the shards in use, each evicting in LRU order. The first
+     * cacheCapacity % activeShards() of them get one extra entry, so the total is exact.
+     */
+    size_t shardCapacity(size_t shard) const {
+        size_t shards = activeShards();
+        if (shard >= shards) return 0;
+        return cacheCapacity / shards + (shard < cacheCapacity % shards);
+    }
+
+    /**
+     * Moves every cached program to the shard its expression maps to after the number of shards
+     * changed. Programs are moved back least recently used first, so each shard keeps the most
+     * recently used of those that now map to it.
+     */
+    void reshard() {
+        CacheShard::Entries entries;
+        for (CacheShard& shard : cacheShards) {
+            lock_guard<mutex> guard(shard.lock);
+            entries.splice(entries.end(), shard.entries);
+            shard.index.clear();
+        }
+        entries.sort([](const CacheEntry& left, const CacheEntry& right) { return left.lastUse < right.lastUse; });
+        while (!entries.empty()) {
+            size_t index = hash<string_view>()(entries.front().expression) % activeShards();
+            CacheShard& shard = cacheShards[index];
+            lock_guard<mutex> guard(shard.lock);
+            shard.entries.splice(shard.entries.begin(), entries, entries.begin());
+            shard.index.emplace(shard.entries.front().expression, shard.entries.begin());
+            evict(shard, shardCapacity(index));
+        }
+    }
+
+    /**
+     * Drops the least recently used entries of a locked shard until at most size remain.
+     */
+    static void evict(CacheShard& shard, size_t size) {
+        while (shard.entries.size() > size) {
+            shard.index.erase(shard.entries.back().expression);
+            shard.entries.pop_back();
+        }
+    }
+
+public:
+    /**
+     * Enables the native code tier: expressions compiled afterwards are translated to
+     * x86-64 machine code once they have been run the given number of times.
+     * Zero (the default) keeps every expression in the bytecode interpreter.
+     *
+     * Like the other setters, this must not be called while other threads use the evaluator.
+     */
+    void setJitThreshold(uint32_t runs) {
+        jitThreshold = runs;
+        clearCache();
+    }
+
+    /**
+     * Selects what arithmetic does on overflow in expressions compiled afterwards. The default,
+     * Checked, reports ErrorCode::Overflow with the position of the operator that overflowed.
+     */
+    void setOverflowPolicy(OverflowPolicy policy) {
+        overflowPolicy = policy;
+        clearCache();
+    }
+
+    /**
+     * Sets how many compiled programs evaluate() keeps, evicting the least recently used
+     * ones if the cache is already larger. Zero disables the cache. The capacity is split
+     * between up to 16 shards by expression hash; below 16 there is one shard per entry.
+     */
+    void setCacheCapacity(size_t capacity) {
+        size_t shards = activeShards();
+        cacheCapacity = capacity;
+        if (activeShards() != shards) reshard();
+        for (size_t index = 0; index < cacheShardCount; ++index) {
+            lock_guard<mutex> guard(cacheShards[index].lock);
+            evict(cacheShards[index], shardCapacity(index));
+        }
+    }
+
+    /**
+     * Drops every cached program. The hit and miss counters are kept.
+     */
+    void clearCache() {
+        for (CacheShard& shard : cacheShards) {
+            lock_guard<mutex> guard(shard.lock);
+            evict(shard, 0);
+        }
+    }
+
+    /**
+     * Number of evaluate() calls that found their program in the cache, and that had to compile it.
+     */
+    size_t cacheHits() const {
+        size_t total = 0;
+        for (CacheShard& shard : cacheShards) {
+            lock_guard<mutex> guard(shard.lock);
+            total += shard.hits;
+        }
+        return total;
+    }
+
+    size_t cacheMisses() const {
+        size_t total = 0;
+        for (CacheShard& shard : cacheShards) {
+            lock_guard<mutex> guard(shard.lock);
+            total += shard.misses;
+        }
+        return total;
+    }
+
+    /**
+     * Evaluates many independent expressions in parallel and returns their results and
+     * error codes in input order. Each expression is compiled with the worker's reusable
+     * scratch buffers and run once; the cache is bypassed because batch items rarely repeat.
+     *
+     * threads is the number of workers including the calling thread (0 = one per core).
+     * Every worker starts with an equal share of the items and steals from the others
+     * once its own share is done, so uneven expression sizes still balance out.
+     */
+    BatchResult evaluateBatch(span<const string_view> expressions, unsigned threads = 0) const {
+        BatchResult result;
+        result.values.assign(expressions.size(), 0);
+        result.errors.assign(expressions.size(), ErrorCode::None);
+
+        // Work ranges pack 32-bit indices, so very large batches are processed in slices.
+        constexpr size_t sliceSize = UINT32_MAX;
+        for (size_t base = 0; base < expressions.size(); base += sliceSize) {
+            size_t count = min(sliceSize, expressions.size() - base);
+            evaluateSlice(expressions.subspan(base, count), threads, overflowPolicy,
+                          result.values.data() + base, result.errors.data() + base);
+        }
+        return result;
+    }
+
+private:
+    /**
+     * Number of items a batch worker takes from its own range at a time.
+     */
+    static constexpr uint32_t batchChunkSize = 64;
+
+    static void evaluateSlice(span<const string_view> expressions, unsigned threads, OverflowPolicy policy,
+                              int* values, ErrorCode* errors) {
+        uint32_t count = static_cast<uint32_t>(expressions.size());
+        if (threads == 0) threads = max(1u, thread::hardware_concurrency());
+        unsigned workers = static_cast<unsigned>(min<uint64_t>(threads, (count + batchChunkSize - 1) / batchChunkSize));
+        if (workers == 0) return;
+
+        vector<WorkRange> ranges(workers);
+        for (unsigned w = 0; w < workers; ++w)
+            ranges[w].assign(static_cast<uint32_t>(uint64_t(count) * w / workers),
+                             static_cast<uint32_t>(uint64_t(count) * (w + 1) / workers));
+
+        mutex failureLock;
+        exception_ptr failure;
+
+        auto work = [&](unsigned self) {
+            CompileScratch& scratch = threadScratch();
+            uint32_t begin, end;
+            try {
+                for (;;) {
+                    while (ranges[self].take(batchChunkSize, begin, end)) {
+                        for (uint32_t i = begin; i < end; ++i) {
+                            try {
+                                values[i] = evaluateWithScratch(expressions[i], policy, scratch);
+                            } catch (const ExpressionError& e) {
+                                errors[i] = e.code();
+                            }
+                        }
+                    }
+
+                    bool stolen = false;
+                    for (unsigned k = 1; k < workers && !stolen; ++k) {
+                        if (ranges[(self + k) % workers].steal(begin, end)) {
+                            ranges[self].assign(begin, end);
+                            stolen = true;
+                        }
+                    }
+                    if (!stolen) return;
+                }
+            } catch (...) {
+                // Anything other than an ExpressionError (e.g. bad_alloc) fails the whole batch.
+                lock_guard<mutex> guard(failureLock);
+                if (!failure) failure = current_exception();
+            }
+        };
+
+        vector<thread> pool;
+        for (unsigned w = 1; w < workers; ++w) pool.emplace_back(work, w);
+        work(0);
+        for (thread& worker : pool) worker.join();
+        if (failure) rethrow_exception(failure);
+    }
+
+public:
+    /**
+     * Main function to be called from main().
+     * Parses, validates, and evaluates a complete infix expression.
+     * Compiled programs are cached by expression text, so repeated expressions skip parsing.
+     * Safe to call from many threads at once on a shared evaluator.
+     */
+    int evaluate(const string& expression) const {
+        if (cacheCapacity == 0) return evaluateWithScratch(expression, overflowPolicy, threadScratch());
+        return compileCached(expression)->run();
+    }
+};
+
+/**
+ * NativeCode: Owns a block of executable memory holding a translated expression.
+ * The function stores a nonzero status into *status instead of returning normally
+ * when evaluation fails, so errors surface as the same ExpressionError as the interpreter's.
+ */
+class NativeCode {
+public:
+    using Function = int (*)(const int* slots, int* status);
+
+    /**
+     * The largest source offset a status can carry. Programs with operators further into their
+     * text stay in the interpreter, so their errors report the full offset.
+     */
+    static constexpr uint32_t maxOffset = (1u << 24) - 1;
+
+    /**
+     * Packs a failure into a status: the ErrorCode in the low byte, the operator's source offset above.
+     */
+    static int32_t status(ErrorCode code, uint32_t offset) {
+        return static_cast<int32_t>(offset << 8 | static_cast<uint32_t>(code));
+    }
+
+    NativeCode(void* memory, size_t length) : memory(memory), length(length) {}
+    NativeCode(const NativeCode&) = delete;
+    NativeCode& operator=(const NativeCode&) = delete;
+
+    ~NativeCode() {
+#if MATHLOGIC_JIT
+        munmap(memory, length);
+#endif
+    }
+
+    int call(const int* slots) const {
+        int status = 0;
+        int result = reinterpret_cast<Function>(memory)(slots, &status);
+        if (status != 0)
+            throwEvaluationError(static_cast<ErrorCode>(status & 0xFF), static_cast<uint32_t>(status) >> 8);
+        return result;
+    }
+
+private:
+    void* memory;
+    size_t length;
+};
+
+#if MATHLOGIC_JIT
+/**
+ * X86Emitter: Translates bytecode to x86-64 machine code.
+ *
+ * The topmost value lives in eax and the rest of the value stack on the machine stack,
+ * so every operator pops its left operand into ecx and leaves its result in eax.
+ * r9 keeps the entry stack pointer so the error path can unwind in one instruction,
+ * rdi holds the variable slots and rsi the status pointer for the whole function.
+ */
+class X86Emitter {
+public:
+    /**
+     * Deepest value stack that is translated; deeper programs stay in the interpreter
+     * rather than risk exhausting the machine stack.
+     */
+    static constexpr uint32_t maxNativeStackDepth = 4096;
+
+    /**
+     * Emits the machine code for a bytecode program of an int expression.
+     * Returns false if the program uses an instruction or policy without a native translation.
+     */
+    bool translate(const vector<uint8_t>& code, OverflowPolicy policy) {
+        // Saturation would need a compare and a cmov per operator; those programs stay interpreted.
+        if (policy == OverflowPolicy::Saturating) return false;
+        checked = policy == OverflowPolicy::Checked;
+
+        emit({0x49, 0x89, 0xE1});                      // mov r9, rsp
+        bool empty = true;
+
+        for (size_t pc = 0; pc < code.size(); ++instructions) {
+            bindBranches(pc);
+            OpCode op = static_cast<OpCode>(code[pc++]);
+            if (op == OpCode::POW || op == OpCode::POWI) return false;  // only x^2 has a native translation
+
+            uint32_t source = 0;
+            if (isArithmetic(op)) {
+                memcpy(&source, &code[pc], sizeof(source));
+                pc += sizeof(source);
+                if (source > NativeCode::maxOffset) return false;
+            }
+
+            switch (op) {
+                case OpCode::PUSH: {
+                    int32_t immediate;
+                    memcpy(&immediate, &code[pc], sizeof(immediate));
+                    pc += sizeof(immediate);
+                    if (!empty) emit({0x50});          // push rax
+                    emit({0xB8});                      // mov eax, imm32
+                    emit32(immediate);
+                    empty = false;
+                    break;
+                }
+                case OpCode::LOAD: {
+                    int32_t slot;
+                    memcpy(&slot, &code[pc], sizeof(slot));
+                    pc += sizeof(slot);
+                    if (!empty) emit({0x50});          // push rax
+                    emit({0x8B, 0x87});                // mov eax, [rdi + disp32]
+                    emit32(slot * static_cast<int32_t>(sizeof(int)));
+                    empty = false;
+                    break;
+                }
+                case OpCode::RESERVE:
+                case OpCode::STORE:
+                case OpCode::FETCH: {
+                    // Temporaries live in a frame below the entry stack pointer saved in r9.
+                    int32_t operand;
+                    memcpy(&operand, &code[pc], sizeof(operand));
+                    pc += sizeof(operand);
+                    if (op == OpCode::RESERVE) {
+                        emit({0x48, 0x81, 0xEC});      // sub rsp, imm32
+                        emit32(operand * 8);
+                        reserved = true;
+                    } else if (op == OpCode::STORE) {
+                        emit({0x41, 0x89, 0x81});      // mov [r9 + disp32], eax
+                        emit32(-8 * (operand + 1));
+                    } else {
+                        if (!empty) emit({0x50});      // push rax
+                        emit({0x41, 0x8B, 0x81});      // mov eax, [r9 + disp32]
+                        emit32(-8 * (operand + 1));
+                        empty = false;
+                    }
+                    break;
+                }
+                case OpCode::JUMP_IF_ZERO:
+                case OpCode::JUMP_IF_NONZERO: {
+                    // The left value stays in eax; a zero there is already the result of &&.
+                    uint32_t distance;
+                    memcpy(&distance, &code[pc], sizeof(distance));
+                    pc += sizeof(distance);
+                    size_t start = bytes.size();
+                    emit({0x85, 0xC0});                // test eax, eax
+                    if (op == OpCode::JUMP_IF_ZERO) {
+                        emit({0x0F, 0x84});            // je past the right side
+                    } else {
+                        emit({0x0F, 0x95, 0xC0, 0x0F, 0xB6, 0xC0});  // setne al; movzx eax, al
+                        emit({0x0F, 0x85});            // jne past the right side
+                    }
+                    branches.push_back({start, bytes.size(), pc + distance, errorJumps.size(), instructions});
+                    emit32(0);
+                    break;
+                }
+                case OpCode::ADD: popLeft(); emit({0x01, 0xC8}); emitOverflowCheck(source); break;  // add eax, ecx
+                case OpCode::SUB:
+                    popLeft();
+                    emit({0x29, 0xC1, 0x89, 0xC8});            // sub ecx, eax; mov eax, ecx
+                    emitOverflowCheck(source);
+                    break;
+                case OpCode::MUL: popLeft(); emit({0x0F, 0xAF, 0xC1}); emitOverflowCheck(source); break;  // imul eax, ecx
+                case OpCode::DIV: popLeft(); emitDivide(source, false); break;
+                case OpCode::MOD: popLeft(); emitDivide(source, true); break;
+                case OpCode::EQ: popLeft(); emitCompare(0x94); break;  // sete
+                case OpCode::NE: popLeft(); emitCompare(0x95); break;  // setne
+                case OpCode::GT: popLeft(); emitCompare(0x9F); break;  // setg
+                case OpCode::LT: popLeft(); emitCompare(0x9C); break;  // setl
+                case OpCode::GE: popLeft(); emitCompare(0x9D); break;  // setge
+                case OpCode::LE: popLeft(); emitCompare(0x9E); break;  // setle
+                case OpCode::AND:
+                    popLeft();
+                    emit({0x85, 0xC9, 0x0F, 0x95, 0xC1});  // test ecx, ecx; setne cl
+                    emit({0x85, 0xC0, 0x0F, 0x95, 0xC0});  // test eax, eax; setne al
+                    emit({0x20, 0xC8, 0x0F, 0xB6, 0xC0});  // and al, cl; movzx eax, al
+                    break;
+                case OpCode::OR:
+                    popLeft();
+                    emit({0x09, 0xC8, 0x0F, 0x95, 0xC0, 0x0F, 0xB6, 0xC0});  // or eax, ecx; setne al; movzx eax, al
+                    break;
+                case OpCode::NOT: emit({0x85, 0xC0, 0x0F, 0x94, 0xC0, 0x0F, 0xB6, 0xC0}); break;  // test; sete al; movzx
+                case OpCode::INC: emit({0x83, 0xC0, 0x01}); emitOverflowCheck(source); break;  // add eax, 1
+                case OpCode::DEC: emit({0x83, 0xE8, 0x01}); emitOverflowCheck(source); break;  // sub eax, 1
+                case OpCode::NEG: emit({0xF7, 0xD8}); emitOverflowCheck(source); break;        // neg eax
+                case OpCode::SQUARE: emit({0x0F, 0xAF, 0xC0}); emitOverflowCheck(source); break;  // imul eax, eax
+                default: return false;
+            }
+        }
+        bindBranches(code.size());
+        if (reserved) emit({0x4C, 0x89, 0xCC});                     // mov rsp, r9
+        emit({0xC3});                                               // ret
+
+        // One error exit per failing operator: unwind the value stack, report the error, and return 0.
+        for (auto [jump, status] : errorJumps) {
+            int32_t distance = static_cast<int32_t>(bytes.size() - (jump + 4));
+            memcpy(&bytes[jump], &distance, sizeof(distance));
+            emit({0x4C, 0x89, 0xCC});                               // mov rsp, r9
+            emit({0xC7, 0x06});                                     // mov dword [rsi], imm32
+            emit32(status);
+            emit({0x31, 0xC0, 0xC3});                               // xor eax, eax; ret
+        }
+        return true;
+    }
+
+    /**
+     * Copies the emitted code into freshly mapped executable memory.
+     */
+    unique_ptr<const NativeCode> finish() const {
+        void* memory = mmap(nullptr, bytes.size(), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (memory == MAP_FAILED) return nullptr;
+        memcpy(memory, bytes.data(), bytes.size());
+        auto native = make_unique<const NativeCode>(memory, bytes.size());
+        if (mprotect(memory, bytes.size(), PROT_READ | PROT_EXEC) != 0) return nullptr;
+        return native;
+    }
+
+private:
+    vector<uint8_t> bytes;
+
+    /**
+     * Whether arithmetic jumps to an error exit on overflow rather than wrapping.
+     */
+    bool checked = false;
+
+    /**
+     * Whether the program set aside a frame for temporaries that must be released on return.
+     */
+    bool reserved = false;
+
+    /**
+     * Offsets of rel32 fields that must be patched to jump to an error exit, with its status.
+     */
+    vector<pair<size_t, int32_t>> errorJumps;
+
+    /**
+     * A && or || jump over a right side that is not yet bound: where its code starts, its rel32
+     * field, its bytecode target, and how many error exits and instructions preceded it.
+     */
+    struct Branch {
+        size_t start;
+        size_t field;
+        size_t target;
+        size_t errorJumps;
+        size_t instructions;
+    };
+
+    /**
+     * The open jumps. Right sides nest, so the innermost one is last.
+     */
+    vector<Branch> branches;
+
+    /**
+     * Number of bytecode instructions translated so far.
+     */
+    size_t instructions = 0;
+
+    /**
+     * Right sides that cannot fail and have at most this many instructions are not branched
+     * over: a mispredicted branch costs more than computing them, and && or || still combines
+     * the two sides correctly.
+     */
+    static constexpr size_t maxBranchlessInstructions = 48;
+
+    /**
+     * Points the jumps that target bytecode offset pc at the code emitted next, or removes them
+     * where the right side is cheap and cannot fail. Jumps nested in a removed one are already
+     * bound and move together with their targets.
+     */
+    void bindBranches(size_t pc) {
+        for (; !branches.empty() && branches.back().target == pc; branches.pop_back()) {
+            const Branch& branch = branches.back();
+            if (branch.errorJumps == errorJumps.size() && instructions - branch.instructions <= maxBranchlessInstructions) {
+                bytes.erase(bytes.begin() + branch.start, bytes.begin() + branch.field + 4);
+                continue;
+            }
+            int32_t distance = static_cast<int32_t>(bytes.size() - (branch.field + 4));
+            memcpy(&bytes[branch.field], &distance, sizeof(distance));
+        }
+    }
+
+    void emit(initializer_list<uint8_t> code) {
+        bytes.insert(bytes.end(), code);
+    }
+
+    void emit32(int32_t value) {
+        const uint8_t* raw = reinterpret_cast<const uint8_t*>(&value);
+        bytes.insert(bytes.end(), raw, raw + sizeof(value));
+    }
+
+    void emitErrorJump(ErrorCode code, uint32_t source) {
+        errorJumps.emplace_back(bytes.size(), NativeCode::status(code, source));
+        emit32(0);
+    }
+
+    void emitOverflowCheck(uint32_t source) {
+        if (!checked) return;
+        emit({0x0F, 0x80});                               // jo error
+        emitErrorJump(ErrorCode::Overflow, source);
+    }
+
+    /**
+     * Points the rel8 jump ending at next to the current position.
+     */
+    void patchJump8(size_t next) {
+        bytes[next - 1] = static_cast<uint8_t>(bytes.size() - next);
+    }
+
+    void popLeft() {
+        emit({0x59});                                     // pop rcx
+    }
+
+    void emitDivide(uint32_t source, bool remainder) {
+        emit({0x85, 0xC0, 0x0F, 0x84});                   // test eax, eax; jz error
+        emitErrorJump(ErrorCode::DivisionByZero, source);
+        emit({0x83, 0xF8, 0xFF, 0x74, 0x00});             // cmp eax, -1; je byMinusOne
+        size_t byMinusOne = bytes.size();
+        emit({0x41, 0x89, 0xC0, 0x89, 0xC8, 0x99});       // mov r8d, eax; mov eax, ecx; cdq
+        emit({0x41, 0xF7, 0xF8});                         // idiv r8d
+        if (remainder) emit({0x89, 0xD0});                // mov eax, edx
+        emit({0xEB, 0x00});                               // jmp done
+        size_t done = bytes.size();
+
+        // Dividing by -1 is negation, done separately because idiv traps on INT_MIN / -1.
+        patchJump8(byMinusOne);
+        if (remainder) {
+            emit({0x31, 0xC0});                           // xor eax, eax
+        } else {
+            emit({0x89, 0xC8, 0xF7, 0xD8});               // mov eax, ecx; neg eax
+            emitOverflowCheck(source);
+        }
+        patchJump8(done);
+    }
+
+    void emitCompare(uint8_t setcc) {
+        emit({0x39, 0xC1, 0x0F, setcc, 0xC0});            // cmp ecx, eax; setcc al
+        emit({0x0F, 0xB6, 0xC0});                         // movzx eax, al
+    }
+};
+#endif
+
+template <typename Value>
+BasicCompiledExpression<Value>::TierState::~TierState() {
+    delete native.load();
+}
+
+template <typename Value>
+const NativeCode* BasicCompiledExpression<Value>::compileNative() const {
+#if MATHLOGIC_JIT
+    // The emitter works on 32-bit registers.
+    if constexpr (is_same_v<Value, int>) {
+        if (maxStackDepth > X86Emitter::maxNativeStackDepth) return nullptr;
+        X86Emitter emitter;
+        if (emitter.translate(code, overflowPolicy)) return emitter.finish().release();
+    }
+#endif
+    return nullptr;
+}
+
+template <typename Value>
+Value BasicCompiledExpression<Value>::run(span<const Value> slots) const {
+    if (slots.size() < variableNames.size())
+        throw ExpressionError("Missing value for variable: " + variableNames[slots.size()], ErrorCode::MissingValue);
+
+    // Exactly one run sees the counter reach the threshold, so native code is built only once.
+    const NativeCode* native = tier->native.load(memory_order_acquire);
+    if (!native && jitThreshold != 0 && tier->runs.load(memory_order_relaxed) < jitThreshold &&
+        tier->runs.fetch_add(1, memory_order_relaxed) + 1 == jitThreshold) {
+        native = compileNative();
+        tier->native.store(native, memory_order_release);
+    }
+    if constexpr (is_same_v<Value, int>) {
+        if (native) return native->call(slots.data());
+    }
+
+    const uint8_t* begin = code.data();
+    if constexpr (inlineStackDepth != 0) {
+        if (maxStackDepth <= inlineStackDepth) {
+            Value values[inlineStackDepth];
+            return execute(overflowPolicy, begin, begin + code.size(), values, slots.data());
+        }
+    }
+    struct Trim {
+        ~Trim() { trimStackArena(); }
+    } trim;
+    return execute(overflowPolicy, begin, begin + code.size(), stackArena(maxStackDepth), slots.data());
+}
+
+template <typename Value>
+Value BasicCompiledExpression<Value>::execute(OverflowPolicy policy, const uint8_t* pc, const uint8_t* end,
+                                              Value* values, const Value* slots) {
+    // BigInt arithmetic is exact, so its programs only fail when a result exceeds BigInt::maxBits,
+    // and floating-point arithmetic never overflows.
+    if constexpr (!isFixedWidth<Value> || is_floating_point_v<Value>) {
+        return execute<CheckedArithmetic>(pc, end, values, slots);
+    } else {
+        switch (policy) {
+            case OverflowPolicy::Wrapping: return execute<WrappingArithmetic>(pc, end, values, slots);
+            case OverflowPolicy::Saturating: return execute<SaturatingArithmetic>(pc, end, values, slots);
+            default: return execute<CheckedArithmetic>(pc, end, values, slots);
+        }
+    }
+}
+
+template <typename Value>
+template <typename Policy>
+Value BasicCompiledExpression<Value>::execute(const uint8_t* pc, const uint8_t* end, Value* values, const Value* slots) {
+    Value* top = values - 1;  // points at the topmost value
+
+    // Arithmetic instructions leave pc at their source offset, which is skipped unless they fail.
+    while (pc != end) {
+        switch (static_cast<OpCode>(*pc++)) {
+            case OpCode::PUSH: {
+                Immediate immediate;
+                memcpy(&immediate, pc, sizeof(immediate));
+                pc += sizeof(immediate);
+                *++top = immediate;
+                break;
+            }
+            case OpCode::LOAD: {
+                uint32_t slot;
+                memcpy(&slot, pc, sizeof(slot));
+                pc += sizeof(slot);
+                *++top = slots[slot];
+                break;
+            }
+            case OpCode::RESERVE: {
+                uint32_t count;
+                memcpy(&count, pc, sizeof(count));
+                pc += sizeof(count);
+                top += count;  // the temporaries sit below the stack
+                break;
+            }
+            case OpCode::STORE: {
+                uint32_t temp;
+                memcpy(&temp, pc, sizeof(temp));
+                pc += sizeof(temp);
+                values[temp] = top[0];
+                break;
+            }
+            case OpCode::FETCH: {
+                uint32_t temp;
+                memcpy(&temp, pc, sizeof(temp));
+                pc += sizeof(temp);
+                *++top = values[temp];
+                break;
+            }
+            case OpCode::JUMP_IF_ZERO: {
+                uint32_t distance;
+                memcpy(&distance, pc, sizeof(distance));
+                pc += sizeof(distance);
+                if (!top[0]) {
+                    top[0] = Value(0);  // a double -0.0 on the left still gives +0.0, as in the block kernels
+                    pc += distance;
+                }
+                break;
+            }
+            case OpCode::JUMP_IF_NONZERO: {
+                uint32_t distance;
+                memcpy(&distance, pc, sizeof(distance));
+                pc += sizeof(distance);
+                if (top[0]) {
+                    top[0] = Value(1);
+                    pc += distance;
+                }
+                break;
+            }
+            case OpCode::ADD:
+                if (add<Policy>(top[-1], top[0], top[-1])) fail(ErrorCode::Overflow, pc);
+                --top; pc += sizeof(uint32_t); break;
+            case OpCode::SUB:
+                if (subtract<Policy>(top[-1], top[0], top[-1])) fail(ErrorCode::Overflow, pc);
+                --top; pc += sizeof(uint32_t); break;
+            case OpCode::MUL:
+                if (multiply<Policy>(top[-1], top[0], top[-1])) fail(ErrorCode::Overflow, pc);
+                --top; pc += sizeof(uint32_t); break;
+            case OpCode::DIV:
+                if (top[0] == 0) fail(ErrorCode::DivisionByZero, pc);
+                if (divide<Policy>(top[-1], top[0], top[-1])) fail(ErrorCode::Overflow, pc);
+                --top; pc += sizeof(uint32_t); break;
+            case OpCode::MOD:
+                if (top[0] == 0) fail(ErrorCode::DivisionByZero, pc);
+                top[-1] = remainder(top[-1], top[0]);
+                --top; pc += sizeof(uint32_t); break;
+            case OpCode::POW:
+                if (top[-1] == 0 && top[0] < 0) fail(ErrorCode::DivisionByZero, pc);
+                if (power<Policy>(top[-1], top[0], top[-1])) fail(ErrorCode::Overflow, pc);
+                --top; pc += sizeof(uint32_t); break;
+            case OpCode::SQUARE:
+                if (multiply<Policy>(top[0], top[0], top[0])) fail(ErrorCode::Overflow, pc);
+                pc += sizeof(uint32_t); break;
+            case OpCode::POWI: {
+                int32_t exponent;
+                memcpy(&exponent, pc, sizeof(exponent));
+                pc += sizeof(exponent);
+                if (power<Policy>(top[0], exponent, top[0])) fail(ErrorCode::Overflow, pc);
+                pc += sizeof(uint32_t); break;
+            }
+            case OpCode::EQ: top[-1] = top[-1] == top[0]; --top; break;
+            case OpCode::NE: top[-1] = top[-1] != top[0]; --top; break;
+            case OpCode::GT: top[-1] = top[-1] > top[0]; --top; break;
+            case OpCode::LT: top[-1] = top[-1] < top[0]; --top; break;
+            case OpCode::GE: top[-1] = top[-1] >= top[0]; --top; break;
+            case OpCode::LE: top[-1] = top[-1] <= top[0]; --top; break;
+            case OpCode::AND: top[-1] = top[-1] && top[0]; --top; break;
+            case OpCode::OR: top[-1] = top[-1] || top[0]; --top; break;
+            case OpCode::NOT: top[0] = !top[0]; break;
+            case OpCode::INC:
+                if (add<Policy>(top[0], 1, top[0])) fail(ErrorCode::Overflow, pc);
+                pc += sizeof(uint32_t); break;
+            case OpCode::DEC:
+                if (subtract<Policy>(top[0], 1, top[0])) fail(ErrorCode::Overflow, pc);
+                pc += sizeof(uint32_t); break;
+            case OpCode::NEG:
+                // 0 - x would turn -0.0 into +0.0, so doubles flip the sign as the block kernel does.
+                if constexpr (is_floating_point_v<Value>) top[0] = -top[0];
+                else if (subtract<Policy>(0, top[0], top[0])) fail(ErrorCode::Overflow, pc);
+                pc += sizeof(uint32_t); break;
+        }
+    }
+
+    return top[0];
+}
+
+template <typename Value>
+void BasicCompiledExpression<Value>::checkColumns(span<const span<const Value>> columns, size_t rows) const {
+    if (columns.size() < variableNames.size())
+        throw ExpressionError("Missing column for variable: " + variableNames[columns.size()], ErrorCode::MissingValue);
+    for (size_t slot = 0; slot < variableNames.size(); ++slot) {
+        if (columns[slot].size() < rows)
+            throw ExpressionError("Column for variable " + variableNames[slot] + " is shorter than the result",
+                                  ErrorCode::MissingValue);
+    }
+}
+
+template <typename Value>
+void BasicCompiledExpression<Value>::runColumns(span<const span<const Value>> columns, span<Value> results) const {
+    static_assert(isFixedWidth<Value>, "column evaluation needs a fixed-width value type");
+    checkColumns(columns, results.size());
+
+    struct Trim {
+        ~Trim() { trimStackArena(); }
+    } trim;
+    Value* values = stackArena(static_cast<size_t>(maxBlockDepth) * blockRows);
+    for (size_t first = 0; first < results.size(); first += blockRows) {
+        size_t rows = min(blockRows, results.size() - first);
+        const Value* block = executeBlock(values, code.data(), code.data() + code.size(), columns, first, nullptr, rows);
+        copy_n(block, rows, results.data() + first);
+    }
+}
+
+template <typename Value>
+vector<uint32_t> BasicCompiledExpression<Value>::filter(span<const span<const Value>> columns, size_t rows) const {
+    static_assert(isFixedWidth<Value>, "column evaluation needs a fixed-width value type");
+    checkColumns(columns, rows);
+
+    vector<uint32_t> selection(rows);
+    for (size_t row = 0; row < rows; ++row) selection[row] = static_cast<uint32_t>(row);
+
+    const ProgramTree& tree = *filterTree;
+    struct Trim {
+        ~Trim() { trimStackArena(); }
+    } trim;
+    Value* values = stackArena(tree.stackDepth * blockRows);
+    filterSubtree(tree, tree.subtreeStart.size() - 1, columns, values, selection, nullptr);
+    return selection;
+}
+
+template <typename Value>
+typename BasicCompiledExpression<Value>::ProgramTree BasicCompiledExpression<Value>::buildProgramTree() const {
+    ProgramTree tree;
+    tree.code.reserve(code.size());
+    vector<pair<size_t, size_t>> temps;  // the expanded code of each temporary
+    vector<size_t> valueStarts;          // where the expanded code of each stacked value starts
+    vector<pair<size_t, size_t>> jumps;  // distance field and original target of each open jump
+
+    for (size_t pc = 0; ; ) {
+        // Expansion moves the ends of right sides, so their jumps are measured again.
+        for (; !jumps.empty() && jumps.back().second == pc; jumps.pop_back()) {
+            uint32_t distance = static_cast<uint32_t>(tree.code.size() - (jumps.back().first + sizeof(distance)));
+            memcpy(&tree.code[jumps.back().first], &distance, sizeof(distance));
+        }
+        if (pc == code.size()) break;
+
+        OpCode op = static_cast<OpCode>(code[pc]);
+        size_t length = 1 + immediateSize(op);
+        size_t start = tree.code.size();
+        uint32_t operand = 0;
+        if (op >= OpCode::RESERVE) memcpy(&operand, &code[pc + 1], sizeof(operand));
+
+        if (op == OpCode::JUMP_IF_ZERO || op == OpCode::JUMP_IF_NONZERO) {
+            tree.code.insert(tree.code.end(), code.begin() + pc, code.begin() + pc + length);
+            jumps.emplace_back(start + 1, pc + length + operand);
+        } else if (op == OpCode::RESERVE) {
+            temps.resize(operand);
+        } else if (op == OpCode::STORE) {
+            temps[operand] = {valueStarts.back(), start};
+        } else if (op == OpCode::FETCH) {
+            auto [begin, end] = temps[operand];
+            tree.code.resize(start + (end - begin));
+            copy_n(tree.code.begin() + begin, end - begin, tree.code.begin() + start);
+            valueStarts.push_back(start);
+        } else {
+            tree.code.insert(tree.code.end(), code.begin() + pc, code.begin() + pc + length);
+            int operands = operandCount(op);
+            if (operands == 0) valueStarts.push_back(start);
+            if (operands == 2) valueStarts.pop_back();
+        }
+        pc += length;
+    }
+
+    vector<size_t> starts;  // subtree start of each value on the simulated stack
+    size_t failing = 0;
+    const vector<uint8_t>& program = tree.code;
+
+    // The tree lives as long as the program, so its arrays are allocated at their final size.
+    size_t instructions = 0;
+    for (size_t pc = 0; pc < program.size(); pc += 1 + immediateSize(static_cast<OpCode>(program[pc]))) ++instructions;
+    tree.offsets.reserve(instructions + 1);
+    tree.failingBefore.reserve(instructions + 1);
+    tree.subtreeStart.reserve(instructions);
+
+    for (size_t pc = 0; pc < program.size(); ) {
+        OpCode op = static_cast<OpCode>(program[pc]);
+        size_t index = tree.offsets.size();
+        tree.offsets.push_back(pc);
+        tree.failingBefore.push_back(failing);
+        failing += canFail(op, overflowPolicy);
+        pc += 1 + immediateSize(op);
+
+        int operands = operandCount(op);
+        if (operands == 0) starts.push_back(index);
+        if (operands == 2) starts.pop_back();  // the left operand's start stays on top
+        tree.stackDepth = max(tree.stackDepth, starts.size());
+        // A unary operator's subtree starts where its operand's does, already on top.
+        tree.subtreeStart.push_back(starts.back());
+    }
+
+    tree.offsets.push_back(program.size());
+    tree.failingBefore.push_back(failing);
+    return tree;
+}
+
+template <typename Value>
+void BasicCompiledExpression<Value>::filterSubtree(const ProgramTree& tree, size_t root, span<const span<const Value>> columns,
+                                                   Value* values, vector<uint32_t>& selection, vector<uint32_t>* failing) const {
+    // A chain of && or || nests as deep as it is long, so the walk keeps its own stack. Each frame
+    // filters one subtree; step counts the sides it has handed to the frames above it. A deque
+    // keeps the sides' row lists in place while frames are pushed.
+    struct Frame {
+        size_t root;
+        vector<uint32_t>* selection;
+        vector<uint32_t>* failing;
+        int step = 0;
+        vector<uint32_t> left, right;  // rows the sides reject, or leave undecided under ||
+
+        Frame(size_t root, vector<uint32_t>* selection, vector<uint32_t>* failing)
+            : root(root), selection(selection), failing(failing) {}
+    };
+    deque<Frame> frames;
+    frames.emplace_back(root, &selection, failing);
+
+    const vector<uint8_t>& program = tree.code;
+    while (!frames.empty()) {
+        Frame& frame = frames.back();
+        if (frame.step == 0) {
+            if (frame.failing) frame.failing->clear();
+            if (frame.selection->empty()) {
+                frames.pop_back();
+                continue;
+            }
+        }
+
+        OpCode op = static_cast<OpCode>(program[tree.offsets[frame.root]]);
+        size_t rightRoot = frame.root - 1;
+        size_t leftRoot = frame.root > 0 ? tree.subtreeStart[rightRoot] - 1 : 0;  // a lone operand has no sides
+        if ((op == OpCode::AND || op == OpCode::OR) && static_cast<OpCode>(program[tree.offsets[leftRoot]]) >= OpCode::JUMP_IF_ZERO)
+            --leftRoot;  // the jump over the right side belongs to neither side
+
+        // && narrows the selection for its right side. || and ! have to track the rows their operand
+        // rejects, which only pays off when short-circuiting can hide an error on the right side.
+        if (op == OpCode::AND) {
+            vector<uint32_t>* leftFailing = frame.failing ? &frame.left : nullptr;
+            vector<uint32_t>* rightFailing = frame.failing ? &frame.right : nullptr;
+            if (frame.step == 0) {
+                frame.step = 1;
+                frames.emplace_back(leftRoot, frame.selection, leftFailing);
+            } else if (frame.step == 1) {
+                frame.step = 2;
+                frames.emplace_back(rightRoot, frame.selection, rightFailing);
+            } else {
+                if (frame.failing)
+                    merge(frame.left.begin(), frame.left.end(), frame.right.begin(), frame.right.end(),
+                          back_inserter(*frame.failing));
+                frames.pop_back();
+            }
+            continue;
+        }
+        if (op == OpCode::OR && tree.canFail(frame.root)) {
+            vector<uint32_t>& undecided = frame.left;
+            if (frame.step == 0) {
+                frame.step = 1;
+                frames.emplace_back(leftRoot, frame.selection, &undecided);
+            } else if (frame.step == 1) {
+                frame.step = 2;
+                frames.emplace_back(rightRoot, &undecided, frame.failing);
+            } else {
+                vector<uint32_t> passing;
+                passing.reserve(frame.selection->size() + undecided.size());
+                merge(frame.selection->begin(), frame.selection->end(), undecided.begin(), undecided.end(),
+                      back_inserter(passing));
+                frame.selection->swap(passing);
+                frames.pop_back();
+            }
+            continue;
+        }
+        if (op == OpCode::NOT && tree.canFail(frame.root)) {
+            vector<uint32_t>& rejected = frame.left;
+            if (frame.step == 0) {
+                frame.step = 1;
+                frames.emplace_back(rightRoot, frame.selection, &rejected);
+            } else {
+                if (frame.failing) frame.failing->swap(*frame.selection);
+                frame.selection->swap(rejected);
+                frames.pop_back();
+            }
+            continue;
+        }
+
+        // Any other subtree is evaluated a block at a time, and its rows are split by the result.
+        vector<uint32_t>& rows = *frame.selection;
+        vector<uint32_t>* rejected = frame.failing;
+        const uint8_t* begin = program.data() + tree.offsets[tree.subtreeStart[frame.root]];
+        const uint8_t* end = program.data() + tree.offsets[frame.root + 1];
+        frames.pop_back();
+
+        if (rejected) rejected->resize(rows.size());
+        size_t kept = 0, dropped = 0;
+        for (size_t first = 0; first < rows.size(); first += blockRows) {
+            size_t count = min(blockRows, rows.size() - first);
+            const Value* block = executeBlock(values, begin, end, columns, 0, rows.data() + first, count);
+            for (size_t i = 0; i < count; ++i) {
+                uint32_t row = rows[first + i];
+                bool pass = block[i] != 0;
+                rows[kept] = row;
+                kept += pass;
+                if (rejected) {
+                    (*rejected)[dropped] = row;
+                    dropped += !pass;
+                }
+            }
+        }
+        rows.resize(kept);
+        if (rejected) rejected->resize(dropped);
+    }
+}
+
+template <typename Value>
+const Value* BasicCompiledExpression<Value>::executeBlock(Value* values, const uint8_t* pc, const uint8_t* end,
+                                                          span<const span<const Value>> columns,
+                                                          size_t first, const uint32_t* selection, size_t rows) const {
+    auto run = [&](bool speculate) {
+        // Floating-point programs have no overflow policy; their kernels never fail on overflow.
+        if constexpr (is_floating_point_v<Value>) {
+            return executeBlock<CheckedArithmetic>(values, pc, end, columns, first, selection, rows, speculate);
+        } else {
+            switch (overflowPolicy) {
+                case OverflowPolicy::Wrapping:
+                    return executeBlock<WrappingArithmetic>(values, pc, end, columns, first, selection, rows, speculate);
+                case OverflowPolicy::Saturating:
+                    return executeBlock<SaturatingArithmetic>(values, pc, end, columns, first, selection, rows, speculate);
+                default:
+                    return executeBlock<CheckedArithmetic>(values, pc, end, columns, first, selection, rows, speculate);
+            }
+        }
+    };
+
+    // A block first runs the right sides of && and || for all of its rows, betting that the rows
+    // their left side decided do not fail on them. If anything fails, the block is run again with
+    // each right side evaluated only for the rows that need it, so the error is only reported if
+    // it counts.
+    try {
+        return run(true);
+    } catch (const ExpressionError&) {
+        return run(false);
+    }
+}
+
+template <typename Value>
+template <typename Policy>
+const Value* BasicCompiledExpression<Value>::executeBlock(Value* values, const uint8_t* pc, const uint8_t* end,
+                                                          span<const span<const Value>> columns,
+                                                          size_t first, const uint32_t* selection, size_t rows,
+                                                          bool speculate, uint32_t temps) const {
+    Value* top = values + temps * blockRows - blockRows;  // points at the topmost block
+
+    while (pc != end) {
+        OpCode op = static_cast<OpCode>(*pc++);
+        Value* left = top - blockRows;
+
+        switch (op) {
+            case OpCode::PUSH: {
+                Immediate immediate;
+                memcpy(&immediate, pc, sizeof(immediate));
+                pc += sizeof(immediate);
+                top += blockRows;
+                fill(top, top + blockRows, static_cast<Value>(immediate));
+                break;
+            }
+            case OpCode::LOAD: {
+                uint32_t slot;
+                memcpy(&slot, pc, sizeof(slot));
+                pc += sizeof(slot);
+                top += blockRows;
+                const Value* column = columns[slot].data();
+                if (selection) {
+                    for (size_t i = 0; i < rows; ++i) top[i] = column[selection[i]];
+                } else {
+                    copy_n(column + first, rows, top);
+                }
+                fill(top + rows, top + blockRows, Value(1));  // harmless padding for a partial block
+                break;
+            }
+            case OpCode::RESERVE: {
+                uint32_t count;
+                memcpy(&count, pc, sizeof(count));
+                pc += sizeof(count);
+                top += count * blockRows;
+                temps += count;
+                break;
+            }
+            case OpCode::STORE: {
+                uint32_t temp;
+                memcpy(&temp, pc, sizeof(temp));
+                pc += sizeof(temp);
+                copy_n(top, blockRows, values + temp * blockRows);
+                break;
+            }
+            case OpCode::FETCH: {
+                uint32_t temp;
+                memcpy(&temp, pc, sizeof(temp));
+                pc += sizeof(temp);
+                top += blockRows;
+                copy_n(values + temp * blockRows, blockRows, top);
+                break;
+            }
+            case OpCode::JUMP_IF_ZERO:
+            case OpCode::JUMP_IF_NONZERO: {
+                uint32_t distance;
+                memcpy(&distance, pc, sizeof(distance));
+                pc += sizeof(distance);
+                const uint8_t* rightEnd = pc + distance - 1;  // the && or || itself
+                bool open = op == OpCode::JUMP_IF_ZERO;     // whether a nonzero left value leaves the result open
+                uint32_t count = 0, limit = static_cast<uint32_t>(rows);  // a fixed trip count lets the loop vectorize
+                for (uint32_t i = 0; i < blockRows; ++i) count += (top[i] != 0) & (i < limit);
+                if (!open) count = limit - count;
+
+                // The right side is skipped once no row needs it. Otherwise the whole block runs
+                // through it, as the kernels work on whole blocks anyway, unless that could report
+                // an error for a row that does not need it.
+                if (count == rows || (count != 0 && (speculate || !canFail(pc, rightEnd)))) break;
+                executeOpenRows<Policy>(values, top, pc, rightEnd, open, columns, first, selection, rows, temps);
+                pc = rightEnd + 1;
+                break;
+            }
+            case OpCode::ADD:
+                if constexpr (is_floating_point_v<Value>) applyToBlock(left, top, [](Value l, Value r) { return l + r; });
+                else if (applyToBlock<Policy>(left, top, rows, [](Value l, Value r, Value& out) { return addInBlock<Policy>(l, r, out); }))
+                    fail(ErrorCode::Overflow, pc);
+                top = left;
+                break;
+            case OpCode::SUB:
+                if constexpr (is_floating_point_v<Value>) applyToBlock(left, top, [](Value l, Value r) { return l - r; });
+                else if (applyToBlock<Policy>(left, top, rows, [](Value l, Value r, Value& out) { return subtractInBlock<Policy>(l, r, out); }))
+                    fail(ErrorCode::Overflow, pc);
+                top = left;
+                break;
+            case OpCode::MUL:
+                if constexpr (is_floating_point_v<Value>) applyToBlock(left, top, [](Value l, Value r) { return l * r; });
+                else if (applyToBlock<Policy>(left, top, rows, [](Value l, Value r, Value& out) { return -Value(multiply<Policy>(l, r, out)); }))
+                    fail(ErrorCode::Overflow, pc);
+                top = left;
+                break;
+            case OpCode::DIV: {
+                if (find(top, top + rows, 0) != top + rows) fail(ErrorCode::DivisionByZero, pc);
+                if constexpr (is_floating_point_v<Value>) {
+                    // Padding rows may divide by zero, which only yields infinities.
+                    applyToBlock(left, top, [](Value l, Value r) { return l / r; });
+                    top = left;
+                    break;
+                }
+                bool failed = false;
+                for (size_t i = 0; i < rows; ++i) failed |= divide<Policy>(left[i], top[i], left[i]);
+                if (failed) fail(ErrorCode::Overflow, pc);
+                top = left;
+                break;
+            }
+            case OpCode::MOD:
+                if (find(top, top + rows, 0) != top + rows) fail(ErrorCode::DivisionByZero, pc);
+                for (size_t i = 0; i < rows; ++i) left[i] = remainder(left[i], top[i]);
+                top = left;
+                break;
+            case OpCode::POW: {
+                bool failed = false;
+                for (size_t i = 0; i < rows; ++i) {
+                    if (left[i] == 0 && top[i] < 0) fail(ErrorCode::DivisionByZero, pc);
+                    failed |= power<Policy>(left[i], top[i], left[i]);
+                }
+                if (failed) fail(ErrorCode::Overflow, pc);
+                top = left;
+                break;
+            }
+            case OpCode::SQUARE:
+                if constexpr (is_floating_point_v<Value>) for (size_t i = 0; i < blockRows; ++i) top[i] *= top[i];
+                else if (applyToBlock<Policy>(top, rows, [](Value v, Value& out) { return -Value(multiply<Policy>(v, v, out)); }))
+                    fail(ErrorCode::Overflow, pc);
+                break;
+            case OpCode::POWI: {
+                int32_t exponent;
+                memcpy(&exponent, pc, sizeof(exponent));
+                pc += sizeof(exponent);
+                bool failed = false;
+                for (size_t i = 0; i < rows; ++i) failed |= power<Policy>(top[i], exponent, top[i]);
+                if (failed) fail(ErrorCode::Overflow, pc);
+                break;
+            }
+            case OpCode::EQ: applyToBlock(left, top, [](Value l, Value r) { return Value(l == r); }); top = left; break;
+            case OpCode::NE: applyToBlock(left, top, [](Value l, Value r) { return Value(l != r); }); top = left; break;
+            case OpCode::GT: applyToBlock(left, top, [](Value l, Value r) { return Value(l > r); }); top = left; break;
+            case OpCode::LT: applyToBlock(left, top, [](Value l, Value r) { return Value(l < r); }); top = left; break;
+            case OpCode::GE: applyToBlock(left, top, [](Value l, Value r) { return Value(l >= r); }); top = left; break;
+            case OpCode::LE: applyToBlock(left, top, [](Value l, Value r) { return Value(l <= r); }); top = left; break;
+            case OpCode::AND: applyToBlock(left, top, [](Value l, Value r) { return Value((l != 0) & (r != 0)); }); top = left; break;
+            case OpCode::OR: applyToBlock(left, top, [](Value l, Value r) { return Value((l != 0) | (r != 0)); }); top = left; break;
+            case OpCode::NOT: for (size_t i = 0; i < blockRows; ++i) top[i] = !top[i]; break;
+            case OpCode::INC:
+                if constexpr (is_floating_point_v<Value>) for (size_t i = 0; i < blockRows; ++i) top[i] += 1;
+                else if (applyToBlock<Policy>(top, rows, [](Value v, Value& out) { return addInBlock<Policy>(v, 1, out); }))
+                    fail(ErrorCode::Overflow, pc);
+                break;
+            case OpCode::DEC:
+                if constexpr (is_floating_point_v<Value>) for (size_t i = 0; i < blockRows; ++i) top[i] -= 1;
+                else if (applyToBlock<Policy>(top, rows, [](Value v, Value& out) { return subtractInBlock<Policy>(v, 1, out); }))
+                    fail(ErrorCode::Overflow, pc);
+                break;
+            case OpCode::NEG:
+                if constexpr (is_floating_point_v<Value>) for (size_t i = 0; i < blockRows; ++i) top[i] = -top[i];
+                else if (applyToBlock<Policy>(top, rows, [](Value v, Value& out) { return subtractInBlock<Policy>(0, v, out); }))
+                    fail(ErrorCode::Overflow, pc);
+                break;
+        }
+        if (isArithmetic(op)) pc += sizeof(uint32_t);  // the source offset
+    }
+
+    return top;
+}
+
+template <typename Value>
+template <typename Policy>
+void BasicCompiledExpression<Value>::executeOpenRows(Value* values, Value* top, const uint8_t* pc, const uint8_t* end, bool open,
+                                                     span<const span<const Value>> columns, size_t first,
+                                                     const uint32_t* selection, size_t rows, uint32_t temps) const {
+    // Right sides can nest, and every level gathers its rows into buffers of its own.
+    thread_local size_t nesting = 0;
+    struct Leave {
+        ~Leave() { --nesting; }
+    } leave;
+    size_t level = nesting++;
+
+    uint32_t* openRows = openRowArena(level);  // positions in the block, then their row indices
+    size_t count = 0;
+    for (size_t i = 0; i < rows; ++i) {
+        openRows[count] = static_cast<uint32_t>(i);
+        count += (top[i] != 0) == open;
+    }
+    for (size_t i = 0; i < blockRows; ++i) top[i] = Value(top[i] != 0);  // the rows the left side decided
+    if (count == 0) return;
+
+    uint32_t* selected = openRows + rows;
+    for (size_t j = 0; j < count; ++j)
+        selected[j] = selection ? selection[openRows[j]] : static_cast<uint32_t>(first + openRows[j]);
+    // The right side runs in the unused blocks above its left value, which blockStackDepth() counts.
+    Value* frame = top + blockRows;
+    for (size_t temp = 0; temp < temps; ++temp)
+        for (size_t j = 0; j < count; ++j) frame[temp * blockRows + j] = values[temp * blockRows + openRows[j]];
+
+    const Value* right = executeBlock<Policy>(frame, pc, end, columns, 0, selected, count, false, temps);
+    for (size_t j = 0; j < count; ++j) top[openRows[j]] = Value(right[j] != 0);
+}
+
+#ifndef MATHLOGIC_NO_MAIN
 /**
  * Entry point of the program. Evaluates a sample expression and prints the result.
+ * The tests in tests/ and the benchmarks in bench/ define MATHLOGIC_NO_MAIN and include this
+ * file to provide their own.
  */
 int main() {
     MathLogicEvaluator evaluator;
@@ -263,3 +3689,4 @@ int main() {
 
     return 0;
 }
+#endif
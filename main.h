@@ -1,7 +1,137 @@
 #ifndef MAIN_H
 #define MAIN_H
 
+#include <cstdint>
+#include <span>
 #include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @brief Categories of expression errors, reported per item by evaluateBatch().
+ */
+enum class ErrorCode : uint8_t {
+    None, Syntax, UnknownVariable, Range, MissingValue, DivisionByZero, Overflow
+};
+
+/**
+ * @brief What arithmetic does when a result does not fit the value type.
+ *
+ * Wrapping uses two's complement, Checked (the default) throws an ExpressionError with
+ * ErrorCode::Overflow and the operator's position, and Saturating clamps to the nearest
+ * representable value. Division and remainder by zero are errors under every policy.
+ */
+enum class OverflowPolicy : uint8_t { Wrapping, Checked, Saturating };
+
+/**
+ * @brief An arbitrary-precision signed integer.
+ *
+ * Values that fit in an int64_t are stored inline; larger ones spill to heap-allocated 32-bit
+ * limbs, and long products use Karatsuba multiplication. BigInt programs are exact, so they
+ * ignore the overflow policy and only report ErrorCode::Overflow for results longer than
+ * maxBits.
+ */
+class BigInt {
+public:
+    static constexpr size_t maxBits = size_t(1) << 20;
+
+    BigInt(int64_t value = 0);
+    explicit operator bool() const;
+
+    /**
+     * @brief Returns true while the value is stored inline, i.e. fits in an int64_t.
+     */
+    bool isInline() const;
+
+    /**
+     * @brief Returns the value in decimal.
+     */
+    std::string toString() const;
+
+private:
+    int64_t small;
+    bool negative;
+    std::vector<uint32_t> limbs;
+};
+
+/**
+ * @brief Per-item results of MathLogicEvaluator::evaluateBatch(), in input order.
+ * values[i] is only meaningful when errors[i] is ErrorCode::None.
+ */
+struct BatchResult {
+    std::vector<int> values;
+    std::vector<ErrorCode> errors;
+};
+
+/**
+ * @brief An immutable, already validated postfix program returned by
+ * MathLogicEvaluator::compile().
+ *
+ * @tparam Value The type all values are computed in: int, int64_t, __int128 (GCC and Clang
+ * only), BigInt or double. Only int programs are translated to native code, and BigInt programs
+ * do not support runColumns() or filter(). Decimal literals (1.5, .25, 2e-3) are only accepted
+ * in double programs.
+ */
+template <typename Value>
+class BasicCompiledExpression {
+public:
+    /**
+     * @brief Evaluates the compiled program without re-parsing it.
+     *
+     * @param slots One value per variable, in the order given by variables().
+     * @return Value The result of the expression evaluation.
+     * @throws ExpressionError if there are any runtime errors (e.g., division by zero),
+     * except on the right side of a && or || that the left side decides.
+     */
+    Value run(std::span<const Value> slots = {}) const;
+
+    /**
+     * @brief Evaluates the program for every row of columnar input, a block of rows at a time.
+     *
+     * @param columns One column per variable, in slot order, each at least results.size() long.
+     * @param results Receives one result per row.
+     * @throws ExpressionError if a column is missing or any row fails to evaluate.
+     */
+    void runColumns(std::span<const std::span<const Value>> columns, std::span<Value> results) const;
+
+    /**
+     * @brief Returns the rows of columnar input for which the expression is nonzero.
+     *
+     * As in run(), errors on the skipped side of && or || are not reported.
+     *
+     * @param columns One column per variable, in slot order, each at least rows long.
+     * @param rows Number of rows to filter.
+     * @return std::vector<uint32_t> Matching row indices in increasing order.
+     */
+    std::vector<uint32_t> filter(std::span<const std::span<const Value>> columns, size_t rows) const;
+
+    /**
+     * @brief Returns the variable names used by the expression, in slot order.
+     */
+    const std::vector<std::string>& variables() const;
+
+    /**
+     * @brief Returns the slot index of a variable, or -1 if it is not used.
+     */
+    int slotOf(const std::string& name) const;
+
+    /**
+     * @brief Reports whether the program has been translated to native code.
+     */
+    bool isNative() const;
+
+private:
+    std::vector<unsigned char> code;
+    std::vector<std::string> variableNames;
+};
+
+using CompiledExpression = BasicCompiledExpression<int>;
+using CompiledExpression64 = BasicCompiledExpression<int64_t>;
+#if defined(__SIZEOF_INT128__)
+using CompiledExpression128 = BasicCompiledExpression<__int128>;
+#endif
+using CompiledExpressionBig = BasicCompiledExpression<BigInt>;
+using CompiledExpressionDouble = BasicCompiledExpression<double>;
 
 /**
  * 
@@ -11,19 +141,88 @@
  * This class supports the following:
  * - Unary operators: !, ++, --, unary -
  * - Binary operators: +, -, *, /, %, ^, >, <, >=, <=, ==, !=, &&, ||
+ * - Short-circuit && and ||: the right side is only evaluated when the left side
+ *   does not decide the result, so 0 && 1 / 0 is 0
  * - Parentheses for grouping
+ * - Variables (e.g., temp, load_5) bound to value slots at compile time
+ *
+ * compile() and evaluate() are const and reentrant; the setters must not be
+ * called while other threads are using the evaluator. The evaluator owns the
+ * mutexes of its cache shards, so it can be neither copied nor moved: share one
+ * by reference, or hold it in a unique_ptr.
 
  */
 class MathLogicEvaluator {
 public:
+    /**
+     * @brief Parses and validates an infix expression once.
+     *
+     * @tparam Value The width values are computed in, e.g. compile<int64_t>("x * 1000").
+     * @param expression A string containing the infix expression (e.g., "1 + 2 * 3").
+     * @return BasicCompiledExpression<Value> A program that can be run repeatedly.
+     * @throws ExpressionError if there are any validation errors or a literal does not fit Value.
+     */
+    template <typename Value = int>
+    BasicCompiledExpression<Value> compile(const std::string& expression) const;
+
+    /**
+     * @brief Compiles an expression against a fixed variable layout.
+     *
+     * @param expression The infix expression (e.g., "temp > 30 && load < 5").
+     * @param variables Variable names; the value of variables[i] is passed in slot i.
+     * @throws ExpressionError if the expression is invalid or uses an unknown variable.
+     */
+    template <typename Value = int>
+    BasicCompiledExpression<Value> compile(const std::string& expression, const std::vector<std::string>& variables) const;
+
+    /**
+     * @brief Enables the x86-64 native code tier for expressions compiled afterwards.
+     *
+     * @param runs Number of runs after which a compiled expression is translated to
+     * machine code. Zero (the default) keeps every expression in the interpreter.
+     */
+    void setJitThreshold(unsigned runs);
+
+    /**
+     * @brief Selects the overflow policy for expressions compiled afterwards.
+     */
+    void setOverflowPolicy(OverflowPolicy policy);
+
+    /**
+     * @brief Sets how many compiled programs evaluate() caches at most (default 1024, zero disables).
+     */
+    void setCacheCapacity(size_t capacity);
+
+    /**
+     * @brief Drops every cached program.
+     */
+    void clearCache();
+
+    /**
+     * @brief Number of evaluate() calls served from the cache, and that had to compile.
+     */
+    size_t cacheHits() const;
+    size_t cacheMisses() const;
+
+    /**
+     * @brief Evaluates many independent expressions on a work-stealing pool of threads.
+     *
+     * @param expressions The expressions to evaluate; none may use variables.
+     * @param threads Number of workers including the caller (0 = one per core).
+     * @return BatchResult Results and error codes in input order.
+     */
+    BatchResult evaluateBatch(std::span<const std::string_view> expressions, unsigned threads = 0) const;
+
     /**
      * @brief Parses, validates, and evaluates an infix expression.
+     * Compiled programs are cached by expression text in a bounded LRU cache.
+     * Safe to call concurrently from many threads on one shared evaluator.
      * 
      * @param expression A string containing the infix expression (e.g., "1 + 2 * 3").
      * @return int The result of the expression evaluation.
      * @throws ExpressionError if there are any validation or runtime errors.
      */
-    int evaluate(const std::string& expression);
+    int evaluate(const std::string& expression) const;
 };
 
 #endif // MAIN_H
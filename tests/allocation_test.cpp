@@ -0,0 +1,67 @@
+/**
+ * Checks that the hot paths do not allocate once they are warm.
+ */
+#include "counting_allocator.h"
+
+#include "test.h"
+
+/**
+ * Runs body once to warm up buffers and caches, then repeatedly, and expects no allocations.
+ */
+template <typename Body>
+static void expectNoAllocations(const string& what, Body body) {
+    body();
+    long before = allocations;
+    for (int i = 0; i < 1000; ++i) body();
+    long allocated = allocations - before;
+    check(allocated == 0, what + ": " + to_string(allocated) + " allocations over 1000 calls");
+}
+
+int main() {
+    MathLogicEvaluator evaluator;
+    const string rule = "(temp_value > 30 && load < 5) || -temp_value * 3 >= load % 7 != !1";
+
+    CompiledExpression program = evaluator.compile(rule, {"temp_value", "load"});
+    int slots[] = {40, 2};
+    expectNoAllocations("run()", [&] { program.run(slots); });
+
+    CompiledExpression64 wide = evaluator.compile<int64_t>(rule, {"temp_value", "load"});
+    int64_t wideSlots[] = {40, 2};
+    expectNoAllocations("run() on int64_t", [&] { wide.run(wideSlots); });
+
+    CompiledExpressionDouble real = evaluator.compile<double>("temp_value * 1.5 > load / 0.25 || load ^ 0.5", {"temp_value", "load"});
+    double realSlots[] = {40, 2};
+    expectNoAllocations("run() on double", [&] { real.run(realSlots); });
+
+    // Deeper than the inline stack, so it runs on the per-thread arena.
+    string deep = "x";
+    for (int i = 0; i < 200; ++i) deep = "(" + to_string(i) + " + " + deep + ")";
+    CompiledExpression deepProgram = evaluator.compile(deep, {"x"});
+    int deepSlots[] = {1};
+    expectNoAllocations("run() on a deep program", [&] { deepProgram.run(deepSlots); });
+
+    MathLogicEvaluator jit;
+    jit.setJitThreshold(1);
+    CompiledExpression native = jit.compile(rule, {"temp_value", "load"});
+    expectNoAllocations("run() on native code", [&] { native.run(slots); });
+
+    vector<int> temps(1000, 40), loads(1000, 2), results(1000);
+    span<const int> columns[] = {temps, loads};
+    expectNoAllocations("runColumns()", [&] { program.runColumns(columns, results); });
+
+    // A frame over the kept size is released when runColumns() returns, so every call allocates it.
+    string deeper = "x";
+    for (int i = 0; i < 5000; ++i) deeper = "(" + to_string(i) + " + " + deeper + ")";
+    CompiledExpression deeperProgram = evaluator.compile(deeper, {"x"});
+    span<const int> deeperColumns[] = {temps};
+    deeperProgram.runColumns(deeperColumns, results);
+    long before = allocations;
+    deeperProgram.runColumns(deeperColumns, results);
+    check(allocations != before, "runColumns() kept the frame of a 5000-deep program");
+
+    const string cached = "(3600 * 24 + 17) % 1000 > 5 && 7 * 6 == 42";
+    expectNoAllocations("evaluate() cache hits", [&] { evaluator.evaluate(cached); });
+    expectNoAllocations("evaluate() cache hits on native code", [&] { jit.evaluate(cached); });
+
+    return finish();
+}
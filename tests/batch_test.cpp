@@ -0,0 +1,80 @@
+/**
+ * Checks evaluateBatch(): results and error codes come back in input order and match compiling
+ * and running each item on its own, for any number of threads and for an empty batch.
+ */
+#include "test.h"
+
+#include <random>
+
+/**
+ * Compiles and runs one expression on its own, returning its value and error code.
+ */
+static pair<int, ErrorCode> single(const MathLogicEvaluator& evaluator, const string& expression) {
+    try {
+        return {evaluator.compile(expression).run(), ErrorCode::None};
+    } catch (const ExpressionError& e) {
+        return {0, e.code()};
+    }
+}
+
+static void compare(const MathLogicEvaluator& evaluator, const vector<string>& items, unsigned threads) {
+    vector<string_view> expressions(items.begin(), items.end());
+    BatchResult result = evaluator.evaluateBatch(expressions, threads);
+    check(result.values.size() == items.size() && result.errors.size() == items.size(),
+          to_string(threads) + " threads: " + to_string(result.errors.size()) + " results for " + to_string(items.size()) + " items");
+    if (result.errors.size() != items.size()) return;
+    for (size_t i = 0; i < items.size(); ++i) {
+        auto [value, error] = single(evaluator, items[i]);
+        check(result.errors[i] == error, to_string(threads) + " threads: item " + to_string(i) + " (" + items[i] +
+                                             ") has error " + to_string(static_cast<int>(result.errors[i])) +
+                                             ", not " + to_string(static_cast<int>(error)));
+        check(error != ErrorCode::None || result.values[i] == value,
+              to_string(threads) + " threads: item " + to_string(i) + " (" + items[i] + ") gave " +
+                  to_string(result.values[i]) + ", not " + to_string(value));
+    }
+}
+
+int main() {
+    MathLogicEvaluator evaluator;
+
+    // Each value is unique to its position, so any reordering shows. Every kind of failure is
+    // mixed in, and some items are much longer than others so that workers steal.
+    mt19937 random(42);
+    vector<string> items;
+    for (int i = 0; i < 5000; ++i) {
+        string item = to_string(i) + " * 3 - 1";
+        switch (random() % 10) {
+            case 0: item += " +"; break;                                  // Syntax
+            case 1: item += " + 99999999999999999999"; break;             // Range
+            case 2: item += " + temp"; break;                             // MissingValue
+            case 3: item += " / (" + to_string(i % 4) + " - 3)"; break;  // DivisionByZero on every fourth
+            case 4: item += " + 2147483647"; break;                       // Overflow
+            case 5:
+                for (int k = 0; k < 200; ++k) item += " + (" + to_string(k) + " > 100)";
+                break;
+            default: break;
+        }
+        items.push_back(item);
+    }
+
+    for (unsigned threads : {0u, 1u, 2u, 3u, 8u, 64u}) compare(evaluator, items, threads);
+
+    // Fewer items than a chunk, and a single item.
+    compare(evaluator, vector<string>(items.begin(), items.begin() + 10), 8);
+    compare(evaluator, {"6 / 0"}, 4);
+
+    // The error codes themselves, at known positions.
+    vector<string_view> mixed = {"1 + 2", "1 +", "99999999999999999999", "x * 2", "1 / 0", "2147483647 + 1", "(7)"};
+    BatchResult result = evaluator.evaluateBatch(mixed, 3);
+    vector<ErrorCode> expected = {ErrorCode::None,         ErrorCode::Syntax,   ErrorCode::Range, ErrorCode::MissingValue,
+                                  ErrorCode::DivisionByZero, ErrorCode::Overflow, ErrorCode::None};
+    check(result.errors == expected, "the mixed batch reported the wrong error codes");
+    check(result.values[0] == 3 && result.values[6] == 7, "the mixed batch gave the wrong values");
+
+    for (unsigned threads : {0u, 1u, 4u}) {
+        BatchResult empty = evaluator.evaluateBatch({}, threads);
+        check(empty.values.empty() && empty.errors.empty(), "an empty batch with " + to_string(threads) + " threads is not empty");
+    }
+
+    return finish();
+}
@@ -0,0 +1,74 @@
+/**
+ * Checks BigInt programs against results computed independently: spilling to limbs and back,
+ * schoolbook, sliced and Karatsuba products, the signs of division and remainder, and the
+ * maxBits overflow limit.
+ */
+#include "test.h"
+
+/**
+ * Compiles and runs a BigInt expression, returning its value in decimal or its error message.
+ */
+static string outcome(const string& expression) {
+    MathLogicEvaluator evaluator;
+    return outcomeOf([&] { return evaluator.compile<BigInt>(expression).run(); });
+}
+
+static void expect(const string& expression, const string& expected) {
+    string actual = outcome(expression);
+    check(actual == expected, expression + " gave " + actual.substr(0, 60) + ", not " + expected.substr(0, 60));
+}
+
+int main() {
+    // Just past int64_t in either direction the value spills to limbs, and comes back inline.
+    MathLogicEvaluator evaluator;
+    BigInt spilled = evaluator.compile<BigInt>("9223372036854775807 + 1").run();
+    check(!spilled.isInline() && spilled.toString() == "9223372036854775808", "INT64_MAX + 1 did not spill");
+    BigInt minimum = evaluator.compile<BigInt>("-9223372036854775807 - 1").run();
+    check(minimum.isInline() && minimum.toString() == "-9223372036854775808", "INT64_MIN is not inline");
+    BigInt back = evaluator.compile<BigInt>("(9223372036854775807 + 1) - 1").run();
+    check(back.isInline() && back.toString() == "9223372036854775807", "INT64_MAX + 1 - 1 did not move back inline");
+    expect("(-9223372036854775807 - 1) / -1", "9223372036854775808");
+    expect("(-9223372036854775807 - 1) * -1 - 9223372036854775807", "1");
+    expect("2 ^ 64 * 3", "55340232221128654848");
+    expect("2 ^ 64 - 2 ^ 64", "0");
+
+    // Products: 10^400 has 42 limbs, so its square is Karatsuba; the other operand sizes pick
+    // the schoolbook method (27 x 5 limbs), balanced Karatsuba (47 x 41) and slices (94 x 35).
+    expect("(10 ^ 400 + 7) * (10 ^ 400 - 7)", string(798, '9') + "51");
+    expect("7 ^ 300 * 11 ^ 40 % 1000000007", "260675759");
+    expect("(2 ^ 1500 - 1) * (2 ^ 1300 + 3) % 1000000007", "81471222");
+    expect("(2 ^ 3000 + 1) * (2 ^ 1100 - 1) % 1000000007", "249490218");
+    expect("(3 ^ 1000) ^ 2 % 998244353", "38370700");
+    expect("(2 ^ 1500 - 1) * (2 ^ 1300 + 3) / (2 ^ 1300 + 3) == 2 ^ 1500 - 1", "1");
+
+    // Division and remainder truncate towards zero, and the remainder takes the dividend's sign.
+    expect("-7 / 2", "-3");
+    expect("-7 % 2", "-1");
+    expect("7 % -2", "1");
+    expect("-(10 ^ 30) / 7", "-142857142857142857142857142857");
+    expect("-(10 ^ 30) % 7", "-1");
+    expect("10 ^ 30 / -7", "-142857142857142857142857142857");
+    expect("10 ^ 30 % -7", "1");
+    expect("(10 ^ 60 + 123) / (10 ^ 25 + 7)", "99999999999999999999999930000000000");
+    expect("(10 ^ 60 + 123) % (10 ^ 25 + 7)", "490000000123");
+    expect("-(2 ^ 200 + 5) / (2 ^ 70 + 3)", "-1361129467683753853850039665213252304896");
+    expect("-(2 ^ 200 + 5) % (2 ^ 70 + 3)", "-10376293541461622789");
+    expect("-(3 ^ 661) % 1000000007", "-501122398");
+    expect("10 ^ 30 / (10 ^ 30 + 1)", "0");
+    expect("10 ^ 30 % 0", "Division by zero @ char: 8");
+
+    // Results of up to maxBits bits are exact; longer ones report overflow at their operator.
+    expect("2 ^ 1048575 % 1000000007", "18110523");
+    expect("2 ^ 1048576", "Integer overflow @ char: 2");
+    expect("2 ^ 1048575 * 2", "Integer overflow @ char: 12");
+    expect("2 ^ 1048575 + 2 ^ 1048575", "Integer overflow @ char: 12");
+    expect("9 ^ 9 ^ 9", "Integer overflow @ char: 2");
+    try {
+        evaluator.compile<BigInt>("2 ^ 1048576").run();
+        check(false, "2 ^ 1048576 did not fail");
+    } catch (const ExpressionError& e) {
+        check(e.code() == ErrorCode::Overflow, "2 ^ 1048576 did not report ErrorCode::Overflow");
+    }
+
+    return finish();
+}
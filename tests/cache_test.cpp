@@ -0,0 +1,99 @@
+/**
+ * Stresses one evaluator shared by 64 threads, and checks the cache capacity bound and that
+ * every capacity caches a repeated expression.
+ */
+#include "test.h"
+
+#include <random>
+
+static string outcome(const MathLogicEvaluator& evaluator, const string& expression) {
+    return outcomeOf([&] { return evaluator.evaluate(expression); });
+}
+
+int main() {
+    // Expressions with values and errors, several times more than the cache holds.
+    vector<string> expressions;
+    const char* ops[] = {"+", "-", "*", "==", "<", "&&", "||", "/"};
+    mt19937 rng(1);
+    for (int i = 0; i < 400; ++i) {
+        string expression = to_string(i + 1);
+        for (int k = 0; k < 5; ++k) expression += string(" ") + ops[rng() % 8] + " " + to_string(rng() % 9);
+        expressions.push_back(expression);
+    }
+    MathLogicEvaluator reference;
+    reference.setCacheCapacity(0);
+    vector<string> expected;
+    for (const string& expression : expressions) expected.push_back(outcome(reference, expression));
+
+    // 64 threads evaluate random expressions on one evaluator, so entries are hit, compiled
+    // concurrently and evicted while other threads run them. Half of the runs are native.
+    MathLogicEvaluator shared;
+    shared.setJitThreshold(5);
+    shared.setCacheCapacity(100);
+    const int threads = 64, evaluations = 5000;
+    atomic<int> mismatches{0};
+    vector<thread> workers;
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t] {
+            mt19937 random(t);
+            for (int i = 0; i < evaluations; ++i) {
+                size_t k = random() % expressions.size();
+                if (outcome(shared, expressions[k]) != expected[k]) ++mismatches;
+            }
+        });
+    }
+    for (thread& worker : workers) worker.join();
+    check(mismatches == 0, to_string(mismatches) + " results differ from a single-threaded evaluator");
+    check(shared.cacheHits() + shared.cacheMisses() == size_t(threads) * evaluations, "hits and misses do not add up");
+    check(shared.cacheHits() > 0, "the cache was never hit");
+
+    // Going back over distinct expressions in reverse order visits the most recent entries of
+    // each shard first, so the hits count exactly the programs the cache kept. 400 expressions
+    // are enough to fill every shard's share.
+    auto cached = [&](const MathLogicEvaluator& evaluator) {
+        size_t before = evaluator.cacheHits();
+        for (auto expression = expressions.rbegin(); expression != expressions.rend(); ++expression)
+            outcome(evaluator, *expression);
+        return evaluator.cacheHits() - before;
+    };
+    for (size_t capacity : {size_t(1), size_t(5), size_t(16), size_t(37), size_t(100)}) {
+        MathLogicEvaluator evaluator;
+        evaluator.setCacheCapacity(capacity);
+        for (const string& expression : expressions) outcome(evaluator, expression);
+        size_t kept = cached(evaluator);
+        check(kept == capacity, "capacity " + to_string(capacity) + " kept " + to_string(kept) + " programs");
+    }
+
+    // Shrinking the capacity evicts down to the new bound.
+    MathLogicEvaluator shrinking;
+    for (const string& expression : expressions) outcome(shrinking, expression);
+    shrinking.setCacheCapacity(3);
+    check(cached(shrinking) == 3, "setCacheCapacity(3) did not keep 3 programs");
+
+    // Changing the number of shards keeps the most recently used programs.
+    MathLogicEvaluator resharded;
+    for (const string& expression : expressions) outcome(resharded, expression);
+    outcome(resharded, expressions[7]);
+    resharded.setCacheCapacity(1);
+    size_t before = resharded.cacheHits();
+    outcome(resharded, expressions[7]);
+    resharded.setCacheCapacity(100);
+    outcome(resharded, expressions[7]);
+    check(resharded.cacheHits() - before == 2, "resharding dropped the most recently used program");
+
+    // Any capacity of 1 or more caches every expression: one repeated expression always hits,
+    // whichever shard it hashes to.
+    for (size_t capacity = 1; capacity <= 40; ++capacity) {
+        MathLogicEvaluator evaluator;
+        evaluator.setCacheCapacity(capacity);
+        size_t missed = 0;
+        for (const string& expression : expressions) {
+            size_t before = evaluator.cacheHits();
+            for (int i = 0; i < 10; ++i) outcome(evaluator, expression);
+            missed += evaluator.cacheHits() - before != 9;
+        }
+        check(missed == 0, "capacity " + to_string(capacity) + ": " + to_string(missed) + " repeated expressions missed");
+    }
+
+    return finish();
+}
@@ -0,0 +1,30 @@
+/**
+ * Replaces the global operator new and delete with versions that count allocations, for
+ * tests/allocation_test.cpp and bench/arena_bench.cpp. A replacement must be defined once per
+ * program, so include this from the one source file of a test or benchmark.
+ */
+#ifndef MATHLOGIC_COUNTING_ALLOCATOR_H
+#define MATHLOGIC_COUNTING_ALLOCATOR_H
+
+#include <cstdlib>
+#include <new>
+
+/**
+ * Number of calls to operator new so far.
+ */
+static long allocations = 0;
+
+// GCC sees free() called on memory from operator new, not knowing both are replaced here.
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+void* operator new(std::size_t size) {
+    ++allocations;
+    if (void* memory = std::malloc(size ? size : 1)) return memory;
+    throw std::bad_alloc();
+}
+void operator delete(void* memory) noexcept { std::free(memory); }
+void operator delete(void* memory, std::size_t) noexcept { std::free(memory); }
+
+#endif
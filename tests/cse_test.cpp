@@ -0,0 +1,131 @@
+/**
+ * Checks that repeated subexpressions are computed once where that is safe, and that sharing
+ * them never changes a result or an error, including repeats on the right side of && and ||,
+ * which may be skipped.
+ */
+#include "test.h"
+
+#include <set>
+
+/**
+ * Runs one row, returning the value or the error message.
+ */
+template <typename Value>
+static string outcome(const BasicCompiledExpression<Value>& program, span<const Value> slots) {
+    return outcomeOf([&] { return program.run(slots); });
+}
+
+/**
+ * The expression is written with u and v for the repeats of x and y. Bound to the same values,
+ * they keep the repeats apart, so that program computes every subtree where it is written; the
+ * shared program replaces them with x and y. Names of equal length keep every offset the same.
+ */
+template <typename Value>
+static void compare(const MathLogicEvaluator& evaluator, string expression, const vector<Value>& x, const vector<Value>& y) {
+    const vector<string> layout = {"x", "y", "u", "v"};
+    BasicCompiledExpression<Value> separate = evaluator.compile<Value>(expression, layout);
+    replace(expression.begin(), expression.end(), 'u', 'x');
+    replace(expression.begin(), expression.end(), 'v', 'y');
+    BasicCompiledExpression<Value> shared = evaluator.compile<Value>(expression, layout);
+
+    size_t rows = x.size();
+    vector<Value> expected(rows);
+    set<string> errors;
+    for (size_t row = 0; row < rows; ++row) {
+        Value slots[] = {x[row], y[row], x[row], y[row]};
+        string separateOutcome = outcome<Value>(separate, slots), sharedOutcome = outcome<Value>(shared, slots);
+        check(sharedOutcome == separateOutcome, expression + " on row " + to_string(row) + ": " + sharedOutcome +
+                                                    " instead of " + separateOutcome);
+        try {
+            expected[row] = separate.run(slots);
+        } catch (const ExpressionError& e) {
+            errors.insert(e.what());
+        }
+    }
+
+    // The block paths must fail if and only if some row does, with one of those rows' errors.
+    span<const Value> columns[] = {x, y, x, y};
+    vector<Value> results(rows);
+    try {
+        shared.runColumns(columns, results);
+        check(errors.empty(), expression + ": runColumns() did not fail");
+        check(errors.size() || results == expected, expression + ": runColumns() values differ");
+    } catch (const ExpressionError& e) {
+        check(errors.count(e.what()), expression + ": runColumns() reported " + e.what());
+    }
+    try {
+        vector<uint32_t> selected = shared.filter(columns, rows), nonzero;
+        for (size_t row = 0; row < rows; ++row)
+            if (expected[row] != 0) nonzero.push_back(static_cast<uint32_t>(row));
+        check(errors.empty(), expression + ": filter() did not fail");
+        check(errors.size() || selected == nonzero, expression + ": filter() rows differ");
+    } catch (const ExpressionError& e) {
+        check(errors.count(e.what()), expression + ": filter() reported " + e.what());
+    }
+}
+
+template <typename Value>
+static void compareAll(const MathLogicEvaluator& evaluator) {
+    // y is zero on every seventh row and x is large on every fifth, so repeats hit division by
+    // zero and overflow on some rows, and are guarded by && or || on others.
+    size_t rows = 600;
+    vector<Value> x(rows), y(rows);
+    for (size_t row = 0; row < rows; ++row) {
+        x[row] = row % 5 == 0 ? Value(2000000000) : Value(static_cast<int>(row % 23) - 11);
+        y[row] = row % 7 == 0 ? Value(0) : Value(static_cast<int>(row % 9) - 4);
+    }
+
+    for (const char* expression : {
+             "(x * y + 1) > 10 && (u * v + 1) < 20",
+             "(x - y) * (u - v) > 4 && (u - v) / v > 0",
+             "y != 0 && x / y > 1 || u / v < -1",
+             "y == 0 || (x / y + u / v > 2 && u / v < 5)",
+             "(x * x * x > 100 || y > 2) && u * u * u < 5000",
+             "x > 3 && (x * y - 1) * (u * v - 1) > 7 || (u * v - 1) > 2",
+             "!(y == 0 || (x % y + 1) * 2 > 3) || (u % v + 1) > 0",
+             "(y != 0 && x / y * 2 > 1) || (v != 0 && u / v * 2 < -1)",
+             "y != 0 && (x / y > 1 && (u / v) * (u / v) > 4)",
+             "(x + 1) * (y + 1) - (u + 1) * (v + 1) + (x - y) > (u - v)"})
+        compare<Value>(evaluator, expression, x, y);
+}
+
+/**
+ * Expects a program over a, b and c to compile to exactly the listed instructions.
+ */
+static void expectInstructions(const MathLogicEvaluator& evaluator, const string& expression, const string& expected) {
+    string actual = ProgramTest::instructions(evaluator.compile(expression, {"a", "b", "c"}));
+    check(actual == expected, expression + " compiled to " + actual + ", not " + expected);
+}
+
+int main() {
+    MathLogicEvaluator checked;
+
+    // A repeat is stored where it is first computed and fetched where it is certain to have run:
+    // after the left side, or earlier in the same right side.
+    expectInstructions(checked, "(a*b+c) > 10 && (a*b+c) < 20",
+                       "RESERVE 1 LOAD 0 LOAD 1 MUL LOAD 2 ADD STORE 0 PUSH 10 GT JUMP_IF_ZERO 12 FETCH 0 PUSH 20 LT AND");
+    expectInstructions(checked, "a > 0 && (a*b+c) + (a*b+c)",
+                       "RESERVE 1 LOAD 0 PUSH 0 GT JUMP_IF_ZERO 41 LOAD 0 LOAD 1 MUL LOAD 2 ADD STORE 0 FETCH 0 ADD AND");
+
+    // A right side may have been skipped, so what it computed is computed again after it.
+    expectInstructions(checked, "a && (a*b+c) > 10 && (a*b+c) < 20",
+                       "LOAD 0 JUMP_IF_ZERO 32 LOAD 0 LOAD 1 MUL LOAD 2 ADD PUSH 10 GT AND "
+                       "JUMP_IF_ZERO 32 LOAD 0 LOAD 1 MUL LOAD 2 ADD PUSH 20 LT AND");
+    expectInstructions(checked, "a > 0 && (a*b+c) > 1 || (a*b+c) < 5",
+                       "LOAD 0 PUSH 0 GT JUMP_IF_ZERO 32 LOAD 0 LOAD 1 MUL LOAD 2 ADD PUSH 1 GT AND "
+                       "JUMP_IF_NONZERO 32 LOAD 0 LOAD 1 MUL LOAD 2 ADD PUSH 5 LT OR");
+
+    compareAll<int>(checked);
+    compareAll<int64_t>(checked);
+    compareAll<double>(checked);
+
+    MathLogicEvaluator wrapping;
+    wrapping.setOverflowPolicy(OverflowPolicy::Wrapping);
+    compareAll<int>(wrapping);
+
+    MathLogicEvaluator saturating;
+    saturating.setOverflowPolicy(OverflowPolicy::Saturating);
+    compareAll<int>(saturating);
+
+    return finish();
+}
@@ -0,0 +1,82 @@
+/**
+ * Checks double programs: literals beyond int64_t and below the double range, and the sign
+ * of zero in every way of running a program.
+ */
+#include "test.h"
+
+/**
+ * Compiles and runs an expression, returning its value or its error message.
+ */
+template <typename Value>
+static string outcome(const string& expression) {
+    MathLogicEvaluator evaluator;
+    return outcomeOf([&] { return evaluator.compile<Value>(expression).run(); });
+}
+
+static void expect(const string& actual, const string& expected, const string& expression) {
+    check(actual == expected, expression + " gave " + actual + ", expected " + expected);
+}
+
+int main() {
+    // Integers too long for int64_t are rounded like any other literal in double programs...
+    expect(outcome<double>("12345678901234567890"), "1.2345678901234567e+19", "12345678901234567890");
+    expect(outcome<double>("9223372036854775808"), "9.2233720368547758e+18", "9223372036854775808");
+    expect(outcome<double>("9223372036854775808 - 1e19"), "-7.7662796314522419e+17", "9223372036854775808 - 1e19");
+    expect(outcome<double>("100000000000000000000000000000 > 1e28"), "1", "100000000000000000000000000000 > 1e28");
+
+    // ...and out of range in integer programs, whichever way they are written.
+    expect(outcome<int>("12345678901234567890"), "Number out of range @ char: 0", "12345678901234567890 as int");
+    expect(outcome<int64_t>("1 + 9223372036854775808"), "Number out of range @ char: 4", "9223372036854775808 as int64_t");
+    expect(outcome<int64_t>("1e19"), "Number out of range @ char: 0", "1e19 as int64_t");
+    expect(outcome<int64_t>("9223372036854775807"), "9223372036854775807", "INT64_MAX as int64_t");
+    expect(outcome<int>("2.5"), "Decimal number in an integer expression @ char: 0", "2.5 as int");
+
+    // Values too small for a double round to zero, but too large ones are still errors.
+    expect(outcome<double>("1e-400"), "0", "1e-400");
+    expect(outcome<double>("1e-400 == 0"), "1", "1e-400 == 0");
+    expect(outcome<double>("4.9e-324 > 0"), "1", "4.9e-324 > 0");
+    expect(outcome<double>("0.00001e-320"), "0", "0.00001e-320");
+    expect(outcome<double>("1e-99999999999999999999999"), "0", "1e-99999999999999999999999");
+    expect(outcome<double>("1e400"), "Number out of range @ char: 0", "1e400");
+    expect(outcome<double>("1" + string(400, '0') + "e-10"), "Number out of range @ char: 0", "10^400 e-10");
+
+    // -x must give -0.0 for x = 0.0 whether run() or the block kernels evaluate it. filter() only
+    // sees zero or nonzero, so it must agree that both zeros are zero.
+    MathLogicEvaluator evaluator;
+    vector<double> xs = {0.0, -0.0, 1.5, -2.0};
+    span<const double> columns[] = {xs};
+    for (const char* expression : {"-x", "-(-x)", "-(x * 1)", "x * -1", "0 - x", "-x + 0 * x", "-0", "-(x - x)"}) {
+        CompiledExpressionDouble program = evaluator.compile<double>(expression, {"x"});
+        vector<double> results(xs.size());
+        program.runColumns(columns, results);
+        vector<uint32_t> nonzero;
+        for (size_t row = 0; row < xs.size(); ++row) {
+            double slots[] = {xs[row]};
+            double value = program.run(slots);
+            check(value == results[row] && signbit(value) == signbit(results[row]),
+                  string(expression) + " with x = " + to_string(xs[row]) + ": run() and runColumns() disagree");
+            if (results[row] != 0) nonzero.push_back(static_cast<uint32_t>(row));
+        }
+        check(program.filter(columns, xs.size()) == nonzero, string(expression) + ": filter() disagrees");
+    }
+    // && that skips its right side gives +0.0 even for a -0.0 left side, in run() as in the kernels.
+    vector<double> zeros = {0.0, -0.0};
+    span<const double> zeroColumns[] = {zeros};
+    for (const char* expression : {"x && x / 0", "x && 1", "(x && x / 0) + 0"}) {
+        CompiledExpressionDouble program = evaluator.compile<double>(expression, {"x"});
+        vector<double> results(zeros.size());
+        program.runColumns(zeroColumns, results);
+        for (size_t row = 0; row < zeros.size(); ++row) {
+            double slots[] = {zeros[row]};
+            double value = program.run(slots);
+            check(value == 0 && !signbit(value) && results[row] == 0 && !signbit(results[row]),
+                  string(expression) + " with x = " + to_string(zeros[row]) + " is not +0.0");
+        }
+    }
+
+    double zero[] = {0.0};
+    check(signbit(evaluator.compile<double>("-x", {"x"}).run(zero)), "-x with x = 0.0 is not -0.0");
+    check(signbit(evaluator.compile<double>("-0").run()), "-0 is not -0.0");
+
+    return finish();
+}
@@ -0,0 +1,88 @@
+/**
+ * Checks filter() against runColumns(), including chains too long to walk recursively.
+ */
+#include "test.h"
+
+/**
+ * Returns the rows filter() selects, or the error it reports.
+ */
+static string filtered(const CompiledExpression& program, span<const span<const int>> columns, size_t rows) {
+    try {
+        string selected;
+        for (uint32_t row : program.filter(columns, rows)) selected += to_string(row) + " ";
+        return selected;
+    } catch (const ExpressionError& e) {
+        return e.what();
+    }
+}
+
+/**
+ * Returns the rows for which runColumns() gives a nonzero result, or the error it reports.
+ */
+static string nonzeroRows(const CompiledExpression& program, span<const span<const int>> columns, size_t rows) {
+    try {
+        vector<int> results(rows);
+        program.runColumns(columns, results);
+        string selected;
+        for (size_t row = 0; row < rows; ++row)
+            if (results[row]) selected += to_string(row) + " ";
+        return selected;
+    } catch (const ExpressionError& e) {
+        return e.what();
+    }
+}
+
+/**
+ * Joins terms(0), terms(1), ... with op into one left-associative chain.
+ */
+template <typename Term>
+static string chain(const string& op, int count, Term term) {
+    string expression = term(0);
+    for (int i = 1; i < count; ++i) expression += " " + op + " " + term(i);
+    return expression;
+}
+
+int main() {
+    MathLogicEvaluator evaluator;
+    const size_t rows = 1000;
+    vector<int> x(rows), y(rows);
+    for (size_t row = 0; row < rows; ++row) {
+        x[row] = static_cast<int>(row % 97) - 48;
+        y[row] = static_cast<int>(row % 13) - 6;
+    }
+    span<const int> columns[] = {x, y};
+
+    vector<string> expressions = {
+        // 50,000 terms nest 50,000 levels deep, far beyond a recursive walk on an 8 MB stack.
+        chain("&&", 50000, [](int i) { return "x > " + to_string(-1 - i); }),
+        chain("||", 50000, [](int i) { return "x == " + to_string(i); }),
+        chain("||", 20000, [](int i) { return "!(y && 100 / y > " + to_string(i % 40) + ")"; }),
+        chain("&&", 20000, [](int i) { return "(y == 0 || x / y < " + to_string(50 + i % 7) + ")"; }),
+        // Shallow shapes that take every path of the walk.
+        "x > 0 && y < 0", "x > 0 || 10 / y > 1", "!(y == 0 || 10 / y > 1)", "!(x > 3 && y)",
+        "y && (x / y > 2 || !(x % y))", "(y == 0 || x / y > 1) && (x == 0 || y / x < 0)", "x + y",
+    };
+
+    for (const string& expression : expressions) {
+        string name = expression.substr(0, 40);
+        CompiledExpression program = evaluator.compile(expression, {"x", "y"});
+        check(filtered(program, columns, rows) == nonzeroRows(program, columns, rows), "filter() differs on " + name);
+        for (size_t row = 0; row < rows; row += 111) {
+            span<const int> single[] = {span<const int>(&x[row], 1), span<const int>(&y[row], 1)};
+            string ran;
+            try {
+                ran = program.run(vector<int>{x[row], y[row]}) ? "0 " : "";
+            } catch (const ExpressionError& e) {
+                ran = e.what();
+            }
+            check(ran == nonzeroRows(program, single, 1), "run() differs on " + name);
+        }
+    }
+
+    // An error the chain cannot skip is still reported.
+    CompiledExpression failing = evaluator.compile(chain("&&", 50000, [](int i) { return "x > " + to_string(-1 - i); }) + " && 1 / y", {"x", "y"});
+    check(filtered(failing, columns, rows).starts_with("Division by zero"),
+          "division by zero at the end of a deep chain is not reported");
+
+    return finish();
+}
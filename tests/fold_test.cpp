@@ -0,0 +1,149 @@
+/**
+ * Checks constant folding: folded operators give what run() computes under every overflow policy,
+ * the folded instructions are gone from the program, errors in a dead && or || side are never
+ * raised, and errors in live code keep their position.
+ */
+#include "test.h"
+
+/**
+ * The value of a successful run, or the ErrorCode of a failed one, as text.
+ */
+template <typename Value>
+static string outcome(const MathLogicEvaluator& evaluator, const string& expression, const vector<string>& variables,
+                      span<const Value> slots) {
+    try {
+        return valueText(evaluator.compile<Value>(expression, variables).run(slots));
+    } catch (const ExpressionError& e) {
+        return "error " + to_string(static_cast<int>(e.code()));
+    }
+}
+
+/**
+ * Folds every operator over pairs of literals and compares it with the same operator applied
+ * to variables, which cannot be folded.
+ */
+template <typename Value>
+static void compareFolding(const MathLogicEvaluator& evaluator, const string& policy) {
+    vector<string> literals = {"0", "1", "2", "7", "-3", "31", "46341", "65536", "2147483647", "(-2147483647 - 1)"};
+    if constexpr (sizeof(Value) == 8)
+        literals.insert(literals.end(), {"3037000500", "4294967296", "9223372036854775807", "(-9223372036854775807 - 1)"});
+    if constexpr (is_floating_point_v<Value>) literals.insert(literals.end(), {"0.5", "-2.5", "1e308"});
+
+    for (const string& a : literals) {
+        for (const string& b : literals) {
+            Value slots[] = {evaluator.compile<Value>(a).run(), evaluator.compile<Value>(b).run()};
+            for (const char* op : {"+", "-", "*", "/", "%", "^", "==", "<", "&&", "||"}) {
+                string folded = outcome<Value>(evaluator, "(" + a + ") " + op + " (" + b + ")", {}, {});
+                string computed = outcome<Value>(evaluator, string("x ") + op + " y", {"x", "y"}, slots);
+                check(folded == computed, policy + ": " + a + " " + op + " " + b + " folds to " + folded + ", not " + computed);
+            }
+        }
+        Value slots[] = {evaluator.compile<Value>(a).run()};
+        for (const char* op : {"-", "!", "++", "--"}) {
+            string folded = outcome<Value>(evaluator, op + ("(" + a + ")"), {}, {});
+            string computed = outcome<Value>(evaluator, string(op) + "x", {"x"}, slots);
+            check(folded == computed, policy + ": " + op + a + " folds to " + folded + ", not " + computed);
+        }
+    }
+}
+
+/**
+ * Compiles and runs an expression, returning its value or its error message. Compiling must
+ * not fail: folding leaves failing operations to run().
+ */
+static string result(const MathLogicEvaluator& evaluator, const string& expression) {
+    try {
+        CompiledExpression program = evaluator.compile(expression, {"x"});
+        try {
+            int slots[] = {5};
+            return to_string(program.run(slots));
+        } catch (const ExpressionError& e) {
+            return e.what();
+        }
+    } catch (const ExpressionError& e) {
+        check(false, expression + ": compiling reported " + e.what());
+        return "";
+    }
+}
+
+static void expect(const MathLogicEvaluator& evaluator, const string& expression, const string& expected) {
+    string actual = result(evaluator, expression);
+    check(actual == expected, expression + " gave " + actual + ", not " + expected);
+}
+
+/**
+ * Expects a Value program over x and y to compile to exactly the listed instructions.
+ */
+template <typename Value = int>
+static void expectInstructions(const MathLogicEvaluator& evaluator, const string& expression, const string& expected) {
+    string actual = ProgramTest::instructions(evaluator.compile<Value>(expression, {"x", "y"}));
+    check(actual == expected, expression + " compiled to " + actual + ", not " + expected);
+}
+
+int main() {
+    MathLogicEvaluator checked, wrapping, saturating;
+    wrapping.setOverflowPolicy(OverflowPolicy::Wrapping);
+    saturating.setOverflowPolicy(OverflowPolicy::Saturating);
+    for (auto [evaluator, policy] : {pair{&checked, "checked"}, pair{&wrapping, "wrapping"}, pair{&saturating, "saturating"}}) {
+        compareFolding<int>(*evaluator, policy);
+        compareFolding<int64_t>(*evaluator, policy);
+    }
+    compareFolding<double>(checked, "double");
+
+    // Folded constants and identities leave no instructions behind.
+    expectInstructions(checked, "(3600 * 24) * x", "PUSH 86400 LOAD 0 MUL");
+    expectInstructions(checked, "(2 + 3) * (x - 1) + 60 * 60", "PUSH 5 LOAD 0 PUSH 1 SUB MUL PUSH 3600 ADD");
+    for (const char* expression : {"x * 1", "1 * x", "x + 0", "0 + x", "x - 0", "x / 1"})
+        expectInstructions(checked, expression, "LOAD 0");
+    expectInstructions<double>(checked, "x * 1", "LOAD 0");
+    expectInstructions<double>(checked, "x + 0", "LOAD 0 PUSH 0 ADD");
+    expectInstructions(checked, "x ^ 0", "PUSH 1");
+    expectInstructions(checked, "x * 0", "PUSH 0");
+
+    // !! and the 1 && and 0 || identities drop only operators applied to a 0-or-1 value.
+    expectInstructions(checked, "!!(x > y)", "LOAD 0 LOAD 1 GT");
+    expectInstructions(checked, "!!x", "LOAD 0 NOT NOT");
+    for (const char* expression : {"1 && x > y", "x > y && 1", "0 || x > y", "x > y || 0"})
+        expectInstructions(checked, expression, "LOAD 0 LOAD 1 GT");
+    expectInstructions(checked, "1 && x", "PUSH 1 JUMP_IF_ZERO 6 LOAD 0 AND");
+
+    // A constant && or || drops its other side only if that side cannot fail.
+    expectInstructions(wrapping, "0 && x + y", "PUSH 0");
+    expectInstructions(checked, "0 && x + y", "PUSH 0 JUMP_IF_ZERO 16 LOAD 0 LOAD 1 ADD AND");
+    expectInstructions(wrapping, "1 || x / y", "PUSH 1 JUMP_IF_NONZERO 16 LOAD 0 LOAD 1 DIV OR");
+    expectInstructions(checked, "1 / 0", "PUSH 1 PUSH 0 DIV");
+
+    // Overflow in constants follows the policy.
+    expect(checked, "2147483647 + 1", "Integer overflow @ char: 11");
+    expect(wrapping, "2147483647 + 1", "-2147483648");
+    expect(saturating, "2147483647 + 1", "2147483647");
+    expect(checked, "2 ^ 31", "Integer overflow @ char: 2");
+    expect(wrapping, "2 ^ 31", "-2147483648");
+    expect(saturating, "-2 ^ 31 * 2", "-2147483648");
+    expect(wrapping, "(3600 * 24 * 365 * 100) % 1000", "-296");
+
+    // Errors on a side of && or || that the other side decides are dropped with it, at compile
+    // time as well as at run time.
+    for (MathLogicEvaluator* evaluator : {&checked, &wrapping}) {
+        expect(*evaluator, "0 && 1 / 0", "0");
+        expect(*evaluator, "1 || 1 / 0", "1");
+        expect(*evaluator, "(2 - 2) && (7 % 0 + x)", "0");
+        expect(*evaluator, "(x > 3 || 5 / (3 - 3)) && x", "1");
+        expect(*evaluator, "0 && (0 ^ -1) || 3 > 2", "1");
+    }
+    expect(checked, "0 && 2147483647 + 1", "0");
+    expect(checked, "1 || (-2147483647 - 2) * x", "1");
+
+    // Errors in live code are raised at run time, at their operator.
+    expect(checked, "1 && 1 / 0", "Division by zero @ char: 7");
+    expect(checked, "(3600 * 24) / (5 - 5)", "Division by zero @ char: 12");
+    expect(checked, "1 + 2 * 3 + 4 / (2 - 2)", "Division by zero @ char: 14");
+    expect(checked, "x + 0 * (2147483647 + 1)", "Integer overflow @ char: 20");
+    expect(checked, "(1 / 0) * 0", "Division by zero @ char: 3");
+    expect(checked, "0 && x || 8 % (1 - 1)", "Division by zero @ char: 12");
+    expect(checked, "0 ^ (0 - 1)", "Division by zero @ char: 2");
+    expect(wrapping, "x * 1 + (7 - 7) / (0 * x)", "Division by zero @ char: 16");
+    expect(checked, "-2147483647 - 2 > x", "Integer overflow @ char: 12");
+
+    return finish();
+}
@@ -0,0 +1,86 @@
+/**
+ * Checks that native code and the interpreter agree on values and errors.
+ */
+#include "test.h"
+
+#include <random>
+
+/**
+ * Runs a program and returns its value, or its error code and message.
+ */
+static string outcome(const CompiledExpression& program, span<const int> slots) {
+    try {
+        return to_string(program.run(slots));
+    } catch (const ExpressionError& e) {
+        return "error " + to_string(static_cast<int>(e.code())) + ": " + e.what();
+    }
+}
+
+/**
+ * Compiles an expression in both tiers and compares the outcomes for every row of slots.
+ */
+static void compare(const MathLogicEvaluator& interpreter, const MathLogicEvaluator& jit, const string& expression,
+                    const vector<vector<int>>& rows, bool expectNative = true) {
+    CompiledExpression interpreted = interpreter.compile(expression, {"x", "y"});
+    CompiledExpression native = jit.compile(expression, {"x", "y"});
+    for (const vector<int>& slots : rows) {
+        string expected = outcome(interpreted, slots);
+        string actual = outcome(native, slots);
+        check(expected == actual, expression + " with x = " + to_string(slots[0]) + ", y = " + to_string(slots[1]) +
+                                      ": interpreter " + expected + ", native " + actual);
+    }
+    check(!MATHLOGIC_JIT || !expectNative || native.isNative(), expression + " was not translated to native code");
+}
+
+int main() {
+    MathLogicEvaluator interpreter, jit;
+    jit.setJitThreshold(1);
+
+    const int values[] = {0, 1, -1, 2, -2, 7, -7, 100, 46341, INT_MAX, INT_MIN, INT_MIN + 1};
+    vector<vector<int>> rows;
+    for (int x : values)
+        for (int y : values) rows.push_back({x, y});
+
+    // Every operator on every pair of edge values: overflow, division by zero and INT_MIN / -1.
+    for (const char* op : {"+", "-", "*", "/", "%", "==", "!=", ">", "<", ">=", "<=", "&&", "||"})
+        compare(interpreter, jit, string("x ") + op + " y", rows);
+    for (const char* expression : {"!x", "++x", "--x", "-x", "x ^ 2", "-x ^ 2", "(x + 1) * (y - 1)", "x / y % 3"})
+        compare(interpreter, jit, expression, rows);
+
+    // Short-circuit: the skipped side must not report its error, the evaluated side must.
+    for (const char* expression : {"x && 1 / y", "x || 1 / y", "x > 0 && x * x > 10", "y == 0 || 100 / y > 3",
+                                   "!x || (x + y) / (x - y) > 0", "(x && y / 0) || 1", "x && (y || x / 0) && x * y",
+                                   "(x > 1 && x < 100) || (y > 1 && 1 / (y - 7))"})
+        compare(interpreter, jit, expression, rows);
+
+    // Random expressions over the same values.
+    const char* ops[] = {"+", "-", "*", "/", "%", "==", "!=", ">", "<", ">=", "<=", "&&", "||"};
+    mt19937 rng(2024);
+    for (int i = 0; i < 2000; ++i) {
+        string expression;
+        int terms = 1 + rng() % 12;
+        for (int k = 0; k < terms; ++k) {
+            if (k) expression += string(" ") + ops[rng() % 13] + " ";
+            switch (rng() % 4) {
+            case 0: expression += "x"; break;
+            case 1: expression += "y"; break;
+            case 2: expression += to_string(rng() % 10); break;
+            default: expression += "(x " + string(ops[rng() % 13]) + " " + to_string(rng() % 5) + ")"; break;
+            }
+        }
+        compare(interpreter, jit, expression, rows);
+    }
+
+    // An operator beyond the offsets a native status can hold keeps the program in the
+    // interpreter, so its error reports the full offset.
+    string padded = string(NativeCode::maxOffset, ' ') + "x / y";
+    CompiledExpression far = jit.compile(padded, {"x", "y"});
+    int zero[] = {1, 0};
+    string expected = "error " + to_string(static_cast<int>(ErrorCode::DivisionByZero)) +
+                      ": Division by zero @ char: " + to_string(NativeCode::maxOffset + 2);
+    string actual = outcome(far, zero);
+    check(actual == expected && !far.isNative(), "division at offset " + to_string(NativeCode::maxOffset + 2) + ": " +
+                                                     actual + (far.isNative() ? ", translated to native code" : ""));
+
+    return finish();
+}
@@ -0,0 +1,85 @@
+/**
+ * Checks decoding of integer literals against std::from_chars: runs around the eight-digit
+ * groups the decoder converts together, leading zeros, and literals exactly at and just past
+ * the range of int, int64_t and __int128 programs.
+ */
+#include "test.h"
+
+#include <random>
+
+/**
+ * Compiles and runs a Value expression, returning its value in decimal or its error message.
+ */
+template <typename Value>
+static string outcome(const string& expression) {
+    MathLogicEvaluator evaluator;
+    return outcomeOf([&] { return evaluator.compile<Value>(expression).run(); });
+}
+
+template <typename Value>
+static void expect(const string& expression, const string& expected) {
+    string actual = outcome<Value>(expression);
+    check(actual == expected, to_string(sizeof(Value) * 8) + "-bit " + expression + " gave " + actual + ", not " + expected);
+}
+
+/**
+ * The digit run must decode to what from_chars makes of it, wherever it ends relative to an
+ * eight-byte group and whatever follows it, or be out of range exactly when from_chars says so.
+ */
+static void compareDigits(const string& digits) {
+    int64_t expected = 0;
+    bool fits = from_chars(digits.data(), digits.data() + digits.size(), expected).ec == errc();
+    string value = fits ? to_string(expected) : "Number out of range @ char: 1";
+    for (const string& expression : {"(" + digits + ")", "(" + digits + " )", "(" + digits + ")*1", "(" + digits + "+0)"})
+        expect<int64_t>(expression, value);
+}
+
+int main() {
+    // Runs of every length up to 25, around the 8-, 16- and 24-digit groups.
+    for (size_t length = 1; length <= 25; ++length) {
+        compareDigits(string(length, '9'));
+        compareDigits("1" + string(length - 1, '0'));
+        compareDigits(string(length - 1, '0') + "7");
+        string counting;
+        for (size_t i = 0; i < length; ++i) counting += static_cast<char>('1' + i % 9);
+        compareDigits(counting);
+    }
+
+    // Seeded runs of 1 to 25 digits, with up to 12 leading zeros on some.
+    mt19937 random(42);
+    uniform_int_distribution<int> lengths(1, 25), digit(0, 9), zeros(0, 12);
+    for (int i = 0; i < 20000; ++i) {
+        string digits = i % 3 ? "" : string(zeros(random), '0');
+        for (int length = lengths(random); length > 0; --length) digits += static_cast<char>('0' + digit(random));
+        compareDigits(digits);
+    }
+
+    // The largest literal of each type, and one past it. Negative limits are written as
+    // expressions, because "-" is an operator and its operand must fit on its own.
+    expect<int>("2147483647", "2147483647");
+    expect<int>("0002147483647", "2147483647");
+    expect<int>("2147483648", "Number out of range @ char: 0");
+    expect<int>("1 + 2147483648", "Number out of range @ char: 4");
+    expect<int>("-2147483647 - 1", "-2147483648");
+    expect<int>("-2147483648", "Number out of range @ char: 1");
+
+    expect<int64_t>("9223372036854775807", "9223372036854775807");
+    expect<int64_t>("00000000009223372036854775807", "9223372036854775807");
+    expect<int64_t>("9223372036854775808", "Number out of range @ char: 0");
+    expect<int64_t>("09223372036854775808", "Number out of range @ char: 0");
+    expect<int64_t>("18446744073709551616", "Number out of range @ char: 0");
+    expect<int64_t>("99999999999999999999", "Number out of range @ char: 0");
+    expect<int64_t>("-9223372036854775807 - 1", "-9223372036854775808");
+    expect<int64_t>("2 * 9223372036854775808", "Number out of range @ char: 4");
+
+#if MATHLOGIC_INT128
+    // Literals are decoded as int64_t, so wider values can only be computed.
+    expect<__int128>("9223372036854775807", "9223372036854775807");
+    expect<__int128>("9223372036854775807 + 1", "9223372036854775808");
+    expect<__int128>("9223372036854775808", "Number out of range @ char: 0");
+    expect<__int128>("0009223372036854775808", "Number out of range @ char: 0");
+    expect<__int128>("-9223372036854775807 - 2", "-9223372036854775809");
+#endif
+
+    return finish();
+}
@@ -0,0 +1,191 @@
+/**
+ * Checks that the Pratt parser and the tokenize, validate and shunting-yard passes it falls back
+ * to agree: the same postfix and variable layout for what the parser accepts, the same error for
+ * what it rejects while scanning, and a fallback for nesting deeper than maxParseDepth.
+ */
+#include "test.h"
+
+/**
+ * What one front end made of an expression: the postfix and variables, or the error it threw.
+ * accepted is false if the Pratt parser left the expression to the three passes.
+ */
+struct FrontEndResult {
+    bool accepted = false;
+    string error;
+    vector<Token> postfix;
+    VariableLayout variables;
+};
+
+struct ParserTest {
+    static FrontEndResult pratt(string_view expression, const vector<string_view>& layout) {
+        FrontEndResult result;
+        result.variables.assign(layout.begin(), layout.end());
+        try {
+            result.accepted = MathLogicEvaluator::parseToPostfix(expression, result.variables, !layout.empty(), result.postfix);
+        } catch (const ExpressionError& e) {
+            result.error = e.what();
+        }
+        return result;
+    }
+
+    static FrontEndResult threePasses(string_view expression, const vector<string_view>& layout) {
+        FrontEndResult result;
+        result.accepted = true;
+        result.variables.assign(layout.begin(), layout.end());
+        try {
+            vector<Token> tokens, operators;
+            MathLogicEvaluator::tokenizeExpression(expression, result.variables, !layout.empty(), tokens);
+            MathLogicEvaluator::validateTokenSequence(tokens);
+            MathLogicEvaluator::convertToPostfix(tokens, result.postfix, operators);
+        } catch (const ExpressionError& e) {
+            result.error = e.what();
+        }
+        return result;
+    }
+};
+
+static bool operator==(const Token& left, const Token& right) {
+    return left.kind == right.kind && left.op == right.op && left.offset == right.offset && left.value == right.value;
+}
+
+/**
+ * Runs both front ends. Where the Pratt parser accepts an expression the passes must produce
+ * the same postfix; where it throws, the passes must throw the same error.
+ */
+static void compare(const string& expression, const vector<string_view>& layout = {}) {
+    FrontEndResult pratt = ParserTest::pratt(expression, layout);
+    FrontEndResult passes = ParserTest::threePasses(expression, layout);
+    if (!pratt.error.empty()) {
+        check(passes.error == pratt.error, "'" + expression + "': the parser reported " + pratt.error +
+                                               ", the passes " + (passes.error.empty() ? "nothing" : passes.error));
+    } else if (pratt.accepted) {
+        check(passes.error.empty(), "'" + expression + "': the parser accepted it, the passes reported " + passes.error);
+        check(passes.postfix == pratt.postfix, "'" + expression + "': the postfix differs");
+        check(passes.variables.names == pratt.variables.names, "'" + expression + "': the variable layout differs");
+    }
+}
+
+/**
+ * Compiles and runs an expression, returning its value or its error message.
+ */
+static string outcome(const string& expression) {
+    MathLogicEvaluator evaluator;
+    return outcomeOf([&] { return evaluator.compile(expression).run(); });
+}
+
+int main() {
+    // Valid: precedence, associativity, prefix and trailing unary operators, and variables.
+    for (const char* expression : {
+             "1 + 2 * 3", "1+2*3", "(1 + 2) * 3", "2 ^ 3 ^ 2", "(2 ^ 3) ^ 2", "-2 ^ 2", "2 ^ -2", "10 - 4 - 3",
+             "100 / 10 / 5", "17 % 5 * 3", "1 < 2 == 3 > 2", "4 >= 4 != 3 <= 2", "!0 && 1 || 0", "0 || 1 && 0",
+             "- - 3", "! ! 5", "-(3 + 4)", "((((7))))", "3 ++", "3 ++ --", "(2) ++ * 4", "++3 + --4", "2 - -3",
+             "5 * -(-2)", "1 + ++2 ^ 2", " 7 ", "x", "temp > 30 && load < 5", "x * x - y / (y + 1)",
+             "a_1 + b2 * a_1", "-x ^ 2 + !y", "(x)-(y)", "x ++ * y --"})
+        compare(expression);
+    compare("load * 2 > temp", {"temp", "load"});
+    compare("-temp", {"temp", "load"});
+
+    // Invalid: the parser either rejects them for the passes to report, or throws what they throw.
+    for (const char* expression : {
+             ")3+2", "3&&&&5", "3 +", "+ 3", "3 4", "x y", "(3 + 4", "3 + 4)", "()", "( )", "3 + * 4", "++ < 5",
+             "1 $ 2", "3 = 4", "3 & 4", "3 | 4", "", "   ", "(", ")", "-", "!", "3 !", "3 ! 4", "x ++ y", "((3)",
+             "3 - - - 4", "(3))", "3 (4)", "(3) 4", "99999999999999999999", "1.5 + 2", "2 + 1e999", "1 + 2 @",
+             "1 + (2 * 3", "* 3 + 4", "3 + 4 *", "1 ++ 2", "! < 3", "#"})
+        compare(expression);
+    compare("temp + speed", {"temp", "load"});
+    compare("(load > 3", {"temp", "load"});
+
+    // The parser nests up to maxParseDepth = 256 levels (parentheses, prefix operators and right
+    // operands) and leaves deeper expressions to the passes, which must give the same values and
+    // report errors at the same positions.
+    uint32_t limit = 256;
+    for (uint32_t depth : {limit - 1, limit, limit + 1, 4 * limit}) {
+        string parenthesized = string(depth, '(') + "7" + string(depth, ')');
+        string negated = "";
+        for (uint32_t i = 0; i < depth; ++i) negated += "- ";
+        negated += "3";
+        string power = "2";
+        for (uint32_t i = 0; i < depth; ++i) power += " ^ 1";
+        for (const string& expression : {parenthesized, negated, power}) {
+            bool accepted = ParserTest::pratt(expression, {}).accepted;
+            check(accepted == (depth <= limit), to_string(depth) + " levels: the parser " +
+                                                    (accepted ? "accepted" : "rejected") + " " + expression.substr(0, 20));
+            compare(expression);
+        }
+        check(outcome(parenthesized) == "7", to_string(depth) + " parentheses do not give 7");
+        check(outcome(negated) == (depth % 2 ? "-3" : "3"), to_string(depth) + " minus signs give " + outcome(negated));
+        check(outcome(power) == "2", to_string(depth) + " powers do not give 2");
+
+        size_t divide = depth + 2;
+        string failing = string(depth, '(') + "1 / 0" + string(depth, ')');
+        check(outcome(failing) == "Division by zero @ char: " + to_string(divide), failing.substr(0, 20) + " at depth " +
+                                                                                       to_string(depth) + " gave " + outcome(failing));
+        string unclosed = string(depth, '(') + "1 + 2" + string(depth - 1, ')');
+        check(outcome(unclosed) == "Missing closing parenthesis @ char: 0", "an unclosed parenthesis at depth " +
+                                                                                to_string(depth) + " gave " + outcome(unclosed));
+    }
+
+    // Layouts large enough to grow the name table several times keep every name in its slot,
+    // and names a failed parse appended are dropped before the passes run.
+    MathLogicEvaluator evaluator;
+    vector<string> names;
+    string sum = "0";
+    for (int i = 0; i < 1000; ++i) {
+        names.push_back("v" + to_string(i));
+        sum += " + " + names.back() + " * " + names[i / 2];
+    }
+    vector<int> slots(names.size());
+    int64_t expected = 0;
+    for (int i = 0; i < 1000; ++i) {
+        slots[i] = i % 7;
+        expected += (i % 7) * (i / 2 % 7);
+    }
+    CompiledExpression free = evaluator.compile(sum);
+    check(free.variables() == names, "a free layout of 1000 names is out of order");
+    check(free.run(slots) == expected, "a free layout of 1000 names gives the wrong sum");
+
+    vector<string> reversed(names.rbegin(), names.rend());
+    vector<int> reversedSlots(slots.rbegin(), slots.rend());
+    CompiledExpression fixed = evaluator.compile(sum, reversed);
+    check(fixed.slotOf("v0") == 999 && fixed.slotOf("v999") == 0, "a fixed layout of 1000 names moved them");
+    check(fixed.run(reversedSlots) == expected, "a fixed layout of 1000 names gives the wrong sum");
+    check(outcome(sum + " + w") == "Missing value for variable: v0", "a free layout reports the wrong missing value");
+    try {
+        evaluator.compile(sum + " + w", names);
+        check(false, "an unknown name in a fixed layout was accepted");
+    } catch (const ExpressionError& e) {
+        check(e.what() == "Unknown variable: w @ char: " + to_string(sum.size() + 3), string("wrong error: ") + e.what());
+    }
+
+    int duplicated[] = {4, 9, 2};
+    check(evaluator.compile("x * 10 + y", {"x", "x", "y"}).run(duplicated) == 42, "a duplicated name does not use its first slot");
+    int duplicatedWide[] = {4, 0, 0, 0, 0, 9, 2};
+    check(evaluator.compile("x * 10 + y", {"x", "a", "b", "c", "d", "x", "y"}).run(duplicatedWide) == 42,
+          "a duplicated name in a hashed layout does not use its first slot");
+
+    // Small layouts are searched in order and larger ones hashed; both must find every name.
+    for (size_t count = 1; count <= 3 * VariableLayout::linearScanNames; ++count) {
+        vector<string> layout(names.begin(), names.begin() + count);
+        string expression;
+        for (size_t i = 0; i < count; ++i) expression += (i ? " + v" : "v") + to_string(count - 1 - i);
+        CompiledExpression small = evaluator.compile(expression);
+        CompiledExpression smallFixed = evaluator.compile(expression, layout);
+        check(small.variables() == vector<string>(layout.rbegin(), layout.rend()), to_string(count) + " names are out of order");
+        for (size_t i = 0; i < count; ++i)
+            check(smallFixed.slotOf(layout[i]) == static_cast<int>(i), to_string(count) + " fixed names moved " + layout[i]);
+    }
+    try {
+        evaluator.compile("v0 + w", {"v0", "v1"});
+        check(false, "an unknown name in a small fixed layout was accepted");
+    } catch (const ExpressionError& e) {
+        check(e.what() == string("Unknown variable: w @ char: 5"), string("wrong error: ") + e.what());
+    }
+
+    string nested = "c + " + string(2 * limit, '(') + "b - a" + string(2 * limit, ')');
+    CompiledExpression deep = evaluator.compile(nested);
+    int deepSlots[] = {100, 10, 3};
+    check(deep.variables() == vector<string>{"c", "b", "a"}, "the passes kept names from the failed parse");
+    check(deep.run(deepSlots) == 107, "a nested layout gives the wrong value");
+
+    return finish();
+}
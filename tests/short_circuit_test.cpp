@@ -0,0 +1,137 @@
+/**
+ * Checks that errors on the skipped side of && and || are never reported, including when block
+ * evaluation runs the skipped side speculatively, and that real errors still are.
+ */
+#include "test.h"
+
+#include <set>
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+#endif
+
+/**
+ * Compares runColumns() and filter() with run() on every row. The block paths must fail if and
+ * only if some row fails in run(), with one of those rows' errors; otherwise they must agree
+ * with run() row by row.
+ */
+template <typename Value>
+static void compare(const MathLogicEvaluator& evaluator, const string& expression, const vector<Value>& x,
+                    const vector<Value>& y) {
+    BasicCompiledExpression<Value> program = evaluator.compile<Value>(expression, {"x", "y"});
+    size_t rows = x.size();
+    vector<Value> expected(rows);
+    set<string> errors;
+    for (size_t row = 0; row < rows; ++row) {
+        try {
+            expected[row] = program.run(vector<Value>{x[row], y[row]});
+        } catch (const ExpressionError& e) {
+            errors.insert(e.what());
+        }
+    }
+
+    span<const Value> columns[] = {x, y};
+    auto reported = [&](auto body, const string& path) {
+        try {
+            body();
+            if (!errors.empty()) check(false, expression + ": " + path + " did not report " + *errors.begin());
+            return true;
+        } catch (const ExpressionError& e) {
+            check(errors.count(e.what()), expression + ": " + path + " reported " + e.what() +
+                                              (errors.empty() ? ", which run() skips" : ", not an error of run()"));
+            return false;
+        }
+    };
+
+    vector<Value> results(rows);
+    if (reported([&] { program.runColumns(columns, results); }, "runColumns()"))
+        check(results == expected, expression + ": runColumns() values differ from run()");
+
+    vector<uint32_t> selected;
+    if (reported([&] { selected = program.filter(columns, rows); }, "filter()")) {
+        vector<uint32_t> nonzero;
+        for (size_t row = 0; row < rows; ++row)
+            if (expected[row] != 0) nonzero.push_back(static_cast<uint32_t>(row));
+        check(selected == nonzero, expression + ": filter() rows differ from run()");
+    }
+}
+
+template <typename Value>
+static void compareAll(const MathLogicEvaluator& evaluator) {
+    // Three blocks of rows. y is zero on every seventh row, and x is large on every fifth, so
+    // speculation hits division by zero and overflow in most blocks.
+    size_t rows = 700;
+    vector<Value> x(rows), y(rows);
+    for (size_t row = 0; row < rows; ++row) {
+        x[row] = row % 5 == 0 ? Value(2000000000) : Value(static_cast<int>(row % 23) - 11);
+        y[row] = row % 7 == 0 ? Value(0) : Value(static_cast<int>(row % 9) - 4);
+    }
+
+    // Guarded: every error is on a row the other side of && or || skips.
+    for (const char* expression : {
+             "y != 0 && x / y > 1", "y == 0 || x / y > 1", "!(y == 0 || x % y == 0)",
+             "x < 1000 && x * x > 50", "x > 1000 || x * x * x < 0", "(y != 0 && x / y > 2) || (y == 0 && x > 3)",
+             "y && (x / y > 2 || (x < 1000 && x * x > 9))", "(y != 0 && (x + 1) / y > 2) || (x + 1) * 2 > 5",
+             "y != 0 && x / y + x / y > 1", "(x > 1000 || y == 0 || (x * x) / y > 1) && x", "y == 0 || !(x / y)"})
+        compare<Value>(evaluator, expression, x, y);
+
+    // Unguarded: some row really fails, and the error must survive the rerun without speculation.
+    for (const char* expression : {"x / y > 1", "y != 1 && x / (y - 1) > 1", "y == 0 || x / (y - 3) > 1",
+                                   "x > 1000 || x * x * x * x > 1", "(y != 0 && x / y > 2) || 10 / y"})
+        compare<Value>(evaluator, expression, x, y);
+}
+
+/**
+ * The peak resident memory of the process in MB so far, or 0 where it is not available.
+ */
+static long peakMegabytes() {
+#if defined(__APPLE__)
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss >> 20;  // bytes
+#elif defined(__unix__)
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss >> 10;  // kilobytes
+#else
+    return 0;
+#endif
+}
+
+int main() {
+    MathLogicEvaluator checked;
+    compareAll<int>(checked);
+    compareAll<int64_t>(checked);
+    compareAll<double>(checked);
+
+    MathLogicEvaluator wrapping;
+    wrapping.setOverflowPolicy(OverflowPolicy::Wrapping);
+    compareAll<int>(wrapping);
+
+    // A single error on the last row of a later block is still found.
+    vector<int> x(600, 1), y(600, 1);
+    y[599] = 0;
+    span<const int> columns[] = {x, y};
+    vector<int> results(600);
+    CompiledExpression program = checked.compile("x > 0 && x / y", {"x", "y"});
+    string error;
+    try {
+        program.runColumns(columns, results);
+    } catch (const ExpressionError& e) {
+        error = e.what();
+    }
+    check(error == "Division by zero @ char: 11", "the error on row 599 was reported as '" + error + "'");
+
+    // 250 nested right sides, each open for one row fewer, around an 8000-deep chain. Speculation
+    // fails on 10 / (x - 100), so every level runs on its own rows; the frames must not add up.
+    string deep = "10 / (x - 100) > 0";
+    for (int k = 7999; k >= 0; --k) deep = "y + " + to_string(k) + " > 0 && (" + deep + ")";
+    for (int k = 249; k >= 0; --k) deep = "x > " + to_string(k) + " && (" + deep + ")";
+    vector<int> rowsX(256), rowsY(256, 1);
+    for (int row = 0; row < 256; ++row) rowsX[row] = row;
+    long before = peakMegabytes();
+    compare<int>(checked, deep, rowsX, rowsY);
+    long grown = peakMegabytes() - before;
+    check(grown < 256, "deeply nested right sides took " + to_string(grown) + " MB");
+
+    return finish();
+}
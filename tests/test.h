@@ -0,0 +1,103 @@
+/**
+ * Shared helpers for the tests in tests/. Each test is a standalone program that includes
+ * main.cpp, prints every failed check, and returns nonzero if any check failed.
+ */
+#ifndef MATHLOGIC_TEST_H
+#define MATHLOGIC_TEST_H
+
+#define MATHLOGIC_NO_MAIN
+#include "../main.cpp"
+
+#include <cstdio>
+
+/**
+ * Number of failed checks so far.
+ */
+inline int failures = 0;
+
+inline void check(bool condition, const string& what) {
+    if (!condition) {
+        ++failures;
+        cout << "FAIL " << what << endl;
+    }
+}
+
+/**
+ * A value in decimal: doubles with 17 significant digits, so that they round-trip, and
+ * integers of any width, including __int128 and BigInt.
+ */
+template <typename Value>
+string valueText(Value value) {
+    if constexpr (is_floating_point_v<Value>) {
+        char text[32];
+        snprintf(text, sizeof(text), "%.17g", value);
+        return text;
+    } else if constexpr (is_same_v<Value, BigInt>) {
+        return value.toString();
+    } else {
+        string text;
+        bool negative = value < 0;
+        do {
+            text.insert(text.begin(), static_cast<char>('0' + (negative ? -(value % 10) : value % 10)));
+            value /= 10;
+        } while (value != 0);
+        return negative ? "-" + text : text;
+    }
+}
+
+/**
+ * Runs body, returning its value as text or the message of the ExpressionError it throws.
+ */
+template <typename Body>
+string outcomeOf(Body body) {
+    try {
+        return valueText(body());
+    } catch (const ExpressionError& e) {
+        return e.what();
+    }
+}
+
+/**
+ * Reads compiled programs, which declare it a friend, so that tests can check what the
+ * optimization passes emit.
+ */
+struct ProgramTest {
+    /**
+     * The instructions of a program separated by spaces, each followed by its immediate, if any,
+     * but not by its source offset: "PUSH 86400 LOAD 0 MUL" for (3600 * 24) * x.
+     */
+    template <typename Value>
+    static string instructions(const BasicCompiledExpression<Value>& program) {
+        using Program = BasicCompiledExpression<Value>;
+        static const char* const names[] = {
+            "OR",   "AND",  "EQ",     "NE",   "GT",      "GE",    "LT",    "LE",           "ADD",
+            "SUB",  "MUL",  "DIV",    "MOD",  "POW",     "NOT",   "INC",   "DEC",          "NEG",
+            "PUSH", "LOAD", "SQUARE", "POWI", "RESERVE", "STORE", "FETCH", "JUMP_IF_ZERO", "JUMP_IF_NONZERO"};
+        string listing;
+        const uint8_t* end = program.code.data() + program.code.size();
+        for (const uint8_t* pc = program.code.data(); pc != end; pc += 1 + Program::immediateSize(static_cast<OpCode>(*pc))) {
+            OpCode op = static_cast<OpCode>(*pc);
+            listing += (listing.empty() ? "" : " ") + string(names[static_cast<int>(op)]);
+            if (op == OpCode::PUSH) {
+                typename Program::Immediate immediate;
+                memcpy(&immediate, pc + 1, sizeof(immediate));
+                listing += " " + valueText(immediate);
+            } else if (op == OpCode::LOAD || op == OpCode::POWI || op >= OpCode::RESERVE) {
+                uint32_t operand;
+                memcpy(&operand, pc + 1, sizeof(operand));
+                listing += " " + to_string(operand);
+            }
+        }
+        return listing;
+    }
+};
+
+/**
+ * Prints OK or FAILED and returns the exit status of the test.
+ */
+inline int finish() {
+    cout << (failures ? "FAILED" : "OK") << endl;
+    return failures ? 1 : 0;
+}
+
+#endif